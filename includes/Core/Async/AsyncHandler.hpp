@@ -0,0 +1,14 @@
+#ifndef NERVA_ASYNC_ASYNC_HANDLER_HPP
+#define NERVA_ASYNC_ASYNC_HANDLER_HPP
+
+#include "Handlers.hpp"
+
+namespace Nerva
+{
+    // Adapts a coroutine handler to the regular handler chain. The task runs
+    // inline until its first suspension; after that res.pending tells the
+    // server to park the connection until the task finishes.
+    RequestHandler Async(AsyncHandler handler);
+}
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef NERVA_ASYNC_COMPLETION_HPP
+#define NERVA_ASYNC_COMPLETION_HPP
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+
+namespace Nerva
+{
+    // One-shot signal raised when a suspended handler finishes. The server
+    // either registers a callback to send the response from whichever thread
+    // finishes it, or blocks on wait().
+    class Completion
+    {
+    public:
+        void finish(std::exception_ptr error);
+
+        // Returns false, without storing the callback, if already finished.
+        bool then(std::function<void()> callback);
+
+        void wait();
+        bool finished();
+        void rethrow();
+
+    private:
+        std::mutex mtx;
+        std::condition_variable cv;
+        bool done = false;
+        std::exception_ptr error;
+        std::function<void()> callback;
+    };
+}
+
+#endif
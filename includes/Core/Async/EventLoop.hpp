@@ -0,0 +1,126 @@
+#ifndef NERVA_ASYNC_EVENT_LOOP_HPP
+#define NERVA_ASYNC_EVENT_LOOP_HPP
+
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <sys/epoll.h>
+
+namespace Nerva
+{
+    // Per-process loop that resumes suspended handler coroutines once their
+    // timers expire or their descriptors become ready. Started lazily, so a
+    // worker only pays for the thread once something is awaited.
+    class EventLoop
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        static EventLoop &Instance();
+
+        // Whether the caller is running on the loop thread, where nothing
+        // may block.
+        static bool InLoop();
+
+        ~EventLoop();
+
+        void Stop();
+
+        void post(std::function<void()> task);
+        void resumeAt(Clock::time_point when, std::coroutine_handle<> handle);
+        // Resumes handle once fd is ready, or at deadline if it is not by then.
+        void resumeWhenReady(int fd, uint32_t events, std::coroutine_handle<> handle,
+                             Clock::time_point deadline = Clock::time_point::max());
+
+    private:
+        struct Watch
+        {
+            std::coroutine_handle<> handle;
+            uint64_t id;
+        };
+
+        // A timer with an fd bounds that watch, and only fires if the watch
+        // with that id is still waiting.
+        struct Timer
+        {
+            Clock::time_point when;
+            std::coroutine_handle<> handle;
+            int fd;
+            uint64_t watch;
+
+            bool operator>(const Timer &other) const { return when > other.when; }
+        };
+
+        EventLoop() = default;
+
+        void ensureRunning();
+        void wake();
+        void run();
+        int nextTimeout();
+
+        int epollFd = -1;
+        int wakeFd = -1;
+        bool running = false;
+        std::thread thread;
+
+        std::mutex mtx;
+        std::vector<std::function<void()>> tasks;
+        std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers;
+        std::unordered_map<int, Watch> watches;
+        uint64_t nextWatch = 0;
+    };
+
+    struct SleepAwaiter
+    {
+        EventLoop::Clock::time_point when;
+
+        bool await_ready() const noexcept { return when <= EventLoop::Clock::now(); }
+        void await_suspend(std::coroutine_handle<> handle) const { EventLoop::Instance().resumeAt(when, handle); }
+        void await_resume() const noexcept {}
+    };
+
+    struct ReadyAwaiter
+    {
+        int fd;
+        uint32_t events;
+        EventLoop::Clock::time_point deadline;
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle) const { EventLoop::Instance().resumeWhenReady(fd, events, handle, deadline); }
+        void await_resume() const noexcept {}
+    };
+
+    struct ScheduleAwaiter
+    {
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle) const
+        {
+            EventLoop::Instance().post([handle]
+                                       { handle.resume(); });
+        }
+        void await_resume() const noexcept {}
+    };
+
+    template <typename Rep, typename Period>
+    SleepAwaiter Sleep(std::chrono::duration<Rep, Period> duration)
+    {
+        return {EventLoop::Clock::now() + std::chrono::duration_cast<EventLoop::Clock::duration>(duration)};
+    }
+
+    inline ReadyAwaiter Readable(int fd) { return {fd, EPOLLIN, EventLoop::Clock::time_point::max()}; }
+    inline ReadyAwaiter Writable(int fd) { return {fd, EPOLLOUT, EventLoop::Clock::time_point::max()}; }
+
+    // Also resumes at deadline if fd is still not readable.
+    inline ReadyAwaiter Readable(int fd, EventLoop::Clock::time_point deadline) { return {fd, EPOLLIN, deadline}; }
+
+    // Moves the awaiting coroutine onto the event loop thread.
+    inline ScheduleAwaiter Schedule() { return {}; }
+}
+
+#endif
@@ -0,0 +1,165 @@
+#ifndef NERVA_ASYNC_OFFLOAD_POOL_HPP
+#define NERVA_ASYNC_OFFLOAD_POOL_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Nerva
+{
+    class OffloadRejected : public std::runtime_error
+    {
+    public:
+        OffloadRejected() : std::runtime_error("offload queue is full") {}
+    };
+
+    // Bounded executor for blocking work (disk writes, legacy clients) kept
+    // apart from the connection workers. Completions are delivered on the
+    // EventLoop, never on a pool thread.
+    class OffloadPool
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        struct Stats
+        {
+            uint64_t submitted = 0;
+            uint64_t rejected = 0;
+            uint64_t completed = 0;
+            uint64_t failed = 0;
+            size_t queued = 0;
+            size_t active = 0;
+            std::chrono::nanoseconds queueWait{0};
+            std::chrono::nanoseconds runTime{0};
+        };
+
+        static OffloadPool &Shared();
+
+        ~OffloadPool();
+
+        // Takes effect when the pool starts, i.e. on the first submit.
+        void configure(size_t threads, size_t queueLimit);
+
+        // Returns false when the queue is full or the pool is stopping; done is
+        // then never called.
+        bool submit(std::function<void()> job, std::function<void(std::exception_ptr)> done);
+
+        Stats stats();
+
+        void Stop();
+
+    private:
+        struct Job
+        {
+            std::function<void()> run;
+            std::function<void(std::exception_ptr)> done;
+            Clock::time_point queuedAt;
+        };
+
+        OffloadPool() = default;
+
+        void work();
+
+        size_t threadCount = 4;
+        size_t queueLimit = 256;
+        bool started = false;
+        bool stopping = false;
+
+        std::mutex mtx;
+        std::condition_variable cv;
+        std::deque<Job> queue;
+        std::vector<std::thread> workers;
+
+        std::atomic<uint64_t> submitted{0};
+        std::atomic<uint64_t> rejected{0};
+        std::atomic<uint64_t> completed{0};
+        std::atomic<uint64_t> failed{0};
+        std::atomic<size_t> active{0};
+        std::atomic<int64_t> queueWaitNs{0};
+        std::atomic<int64_t> runTimeNs{0};
+    };
+
+    template <typename F>
+    class OffloadAwaiter
+    {
+    public:
+        using Result = std::invoke_result_t<F &>;
+
+        OffloadAwaiter(OffloadPool &pool, F fn) : pool(pool), fn(std::move(fn)) {}
+
+        bool await_ready() const noexcept { return false; }
+
+        bool await_suspend(std::coroutine_handle<> handle)
+        {
+            bool queued = pool.submit(
+                [this]
+                {
+                    if constexpr (std::is_void_v<Result>)
+                        fn();
+                    else
+                        result.emplace(fn());
+                },
+                [this, handle](std::exception_ptr failure)
+                {
+                    error = failure;
+                    handle.resume();
+                });
+
+            // On success the coroutine may already be resuming elsewhere, so
+            // this object must not be touched again.
+            if (queued)
+                return true;
+
+            rejected = true;
+            return false;
+        }
+
+        Result await_resume()
+        {
+            if (rejected)
+                throw OffloadRejected();
+            if (error)
+                std::rethrow_exception(error);
+            if constexpr (!std::is_void_v<Result>)
+                return std::move(*result);
+        }
+
+    private:
+        using Storage = std::conditional_t<std::is_void_v<Result>, bool, Result>;
+
+        OffloadPool &pool;
+        F fn;
+        std::optional<Storage> result;
+        std::exception_ptr error;
+        bool rejected = false;
+    };
+
+    // co_await Offload(fn) runs fn on the offload pool and resumes on the event
+    // loop with its result; throws OffloadRejected if the queue is full.
+    template <typename F>
+    OffloadAwaiter<std::decay_t<F>> Offload(F &&fn)
+    {
+        return {OffloadPool::Shared(), std::forward<F>(fn)};
+    }
+
+    // Callback form: done(error) runs on the event loop once fn has finished.
+    template <typename F>
+    bool Offload(F &&fn, std::function<void(std::exception_ptr)> done)
+    {
+        return OffloadPool::Shared().submit(std::forward<F>(fn), std::move(done));
+    }
+}
+
+#endif
@@ -0,0 +1,142 @@
+#ifndef NERVA_ASYNC_TASK_HPP
+#define NERVA_ASYNC_TASK_HPP
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace Nerva
+{
+    template <typename T = void>
+    class Task;
+
+    namespace Detail
+    {
+        struct FinalAwaiter
+        {
+            bool await_ready() const noexcept { return false; }
+
+            template <typename Promise>
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+            {
+                auto continuation = handle.promise().continuation;
+                return continuation ? continuation : std::noop_coroutine();
+            }
+
+            void await_resume() const noexcept {}
+        };
+
+        struct PromiseBase
+        {
+            std::coroutine_handle<> continuation;
+            std::exception_ptr error;
+
+            std::suspend_always initial_suspend() const noexcept { return {}; }
+            FinalAwaiter final_suspend() const noexcept { return {}; }
+            void unhandled_exception() noexcept { error = std::current_exception(); }
+        };
+
+        template <typename T>
+        struct Promise : PromiseBase
+        {
+            std::optional<T> value;
+
+            Task<T> get_return_object();
+            void return_value(T result) { value = std::move(result); }
+        };
+
+        template <>
+        struct Promise<void> : PromiseBase
+        {
+            Task<void> get_return_object();
+            void return_void() const noexcept {}
+        };
+    }
+
+    // Lazily started coroutine; it runs when first awaited and resumes its
+    // awaiter when it finishes.
+    template <typename T>
+    class Task
+    {
+    public:
+        using promise_type = Detail::Promise<T>;
+
+        Task() = default;
+        explicit Task(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+
+        Task(Task &&other) noexcept : handle(std::exchange(other.handle, {})) {}
+
+        Task &operator=(Task &&other) noexcept
+        {
+            if (this != &other)
+            {
+                if (handle)
+                    handle.destroy();
+                handle = std::exchange(other.handle, {});
+            }
+            return *this;
+        }
+
+        Task(const Task &) = delete;
+        Task &operator=(const Task &) = delete;
+
+        ~Task()
+        {
+            if (handle)
+                handle.destroy();
+        }
+
+        bool done() const { return !handle || handle.done(); }
+
+        bool await_ready() const noexcept { return done(); }
+
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+        {
+            handle.promise().continuation = awaiting;
+            return handle;
+        }
+
+        T await_resume()
+        {
+            if (handle.promise().error)
+                std::rethrow_exception(handle.promise().error);
+            if constexpr (!std::is_void_v<T>)
+                return std::move(*handle.promise().value);
+        }
+
+    private:
+        std::coroutine_handle<promise_type> handle;
+    };
+
+    namespace Detail
+    {
+        template <typename T>
+        Task<T> Promise<T>::get_return_object()
+        {
+            return Task<T>(std::coroutine_handle<Promise>::from_promise(*this));
+        }
+
+        inline Task<void> Promise<void>::get_return_object()
+        {
+            return Task<void>(std::coroutine_handle<Promise>::from_promise(*this));
+        }
+    }
+
+    // Eagerly started coroutine that owns itself; used to drive a Task from
+    // non-coroutine code.
+    struct Detached
+    {
+        struct promise_type
+        {
+            Detached get_return_object() const noexcept { return {}; }
+            std::suspend_never initial_suspend() const noexcept { return {}; }
+            std::suspend_never final_suspend() const noexcept { return {}; }
+            void return_void() const noexcept {}
+            void unhandled_exception() const noexcept { std::terminate(); }
+        };
+    };
+}
+
+#endif
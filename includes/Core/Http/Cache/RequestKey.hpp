@@ -0,0 +1,17 @@
+#ifndef REQUEST_KEY_HPP
+#define REQUEST_KEY_HPP
+
+#include <string>
+#include <vector>
+
+#include "Request.hpp"
+#include "Response.hpp"
+
+namespace Http
+{
+    // Method, path, sorted query and the listed vary values ("Cookie:name",
+    // "Query:name" or "Header:name"; a bare name is treated as a header).
+    std::string RequestKey(const Request &req, const Response &res, const std::vector<std::string> &vary);
+}
+
+#endif
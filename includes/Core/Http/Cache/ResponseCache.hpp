@@ -0,0 +1,70 @@
+#ifndef RESPONSE_CACHE_HPP
+#define RESPONSE_CACHE_HPP
+
+#include <string>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <chrono>
+
+namespace Http
+{
+    struct CacheOptions
+    {
+        std::chrono::milliseconds ttl{1000};
+        std::chrono::milliseconds staleWhileRevalidate{0};
+        std::vector<std::string> vary;
+    };
+
+    // Sharded, byte-bounded LRU of fully serialized responses.
+    class ResponseCache
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+        using Bytes = std::shared_ptr<const std::string>;
+
+        explicit ResponseCache(size_t capacityBytes = 64 * 1024 * 1024, size_t shardCount = 16);
+
+        static ResponseCache &Shared();
+
+        void setCapacity(size_t capacityBytes);
+
+        // Returns the bytes to serve, or nullptr when the caller should run the
+        // handler and store its result. Once an entry goes stale, only the first
+        // caller gets nullptr; the rest keep receiving the stale copy until the
+        // refreshed one is stored or the stale window ends.
+        Bytes lookup(const std::string &key, Clock::time_point now);
+
+        void store(const std::string &key, Bytes bytes, Clock::time_point freshUntil, Clock::time_point staleUntil);
+
+        void release(const std::string &key);
+
+    private:
+        struct Entry
+        {
+            Bytes bytes;
+            Clock::time_point freshUntil;
+            Clock::time_point staleUntil;
+            bool revalidating = false;
+        };
+
+        struct Shard
+        {
+            std::mutex mtx;
+            std::list<std::pair<std::string, Entry>> lru;
+            std::unordered_map<std::string, std::list<std::pair<std::string, Entry>>::iterator> index;
+            size_t bytes = 0;
+        };
+
+        std::vector<std::unique_ptr<Shard>> shards;
+        size_t shardCapacity;
+
+        Shard &shardFor(const std::string &key);
+        static size_t charge(const std::string &key, const Entry &entry);
+        void erase(Shard &shard, std::list<std::pair<std::string, Entry>>::iterator it);
+    };
+}
+
+#endif
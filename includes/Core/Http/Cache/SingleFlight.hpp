@@ -0,0 +1,87 @@
+#ifndef SINGLE_FLIGHT_HPP
+#define SINGLE_FLIGHT_HPP
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+#include "Request.hpp"
+#include "Response.hpp"
+#include "RequestKey.hpp"
+
+namespace Http
+{
+    struct CoalesceOptions
+    {
+        std::chrono::milliseconds maxWait{250};
+        std::vector<std::string> vary;
+    };
+
+    // Lets concurrent GET/HEAD requests with the same Http::RequestKey share one
+    // execution. Followers wait up to maxWait for the leader and then receive a
+    // copy of its response; on timeout, or when the leader set cookies, they run
+    // the handler themselves.
+    class SingleFlight
+    {
+    public:
+        explicit SingleFlight(CoalesceOptions options);
+
+        template <typename F>
+        bool run(const Request &req, Response &res, F &&execute)
+        {
+            if (req.method != "GET" && req.method != "HEAD")
+                return execute();
+
+            std::string key = RequestKey(req, res, options.vary);
+            bool leader = false;
+            auto call = join(key, leader);
+
+            if (leader)
+            {
+                bool handled = false;
+                try
+                {
+                    handled = execute();
+                }
+                catch (...)
+                {
+                    finish(key, *call, false, nullptr);
+                    throw;
+                }
+
+                finish(key, *call, handled, handled && !res.hasCookies() && !res.pending && !res.streaming ? &res : nullptr);
+                return handled;
+            }
+
+            bool handled = false;
+            if (await(*call, res, handled))
+                return handled;
+
+            return execute();
+        }
+
+    private:
+        struct Call
+        {
+            std::mutex mtx;
+            std::condition_variable cv;
+            bool done = false;
+            bool handled = false;
+            std::unique_ptr<const Response> response;
+        };
+
+        CoalesceOptions options;
+        std::mutex mtx;
+        std::unordered_map<std::string, std::shared_ptr<Call>> calls;
+
+        std::shared_ptr<Call> join(const std::string &key, bool &leader);
+        bool await(Call &call, Response &res, bool &handled);
+        void finish(const std::string &key, Call &call, bool handled, const Response *response);
+    };
+}
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef ASSET_MANIFEST_HPP
+#define ASSET_MANIFEST_HPP
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace Http
+{
+    // Maps static file paths ("css/app.css") to content-hashed URLs
+    // ("/static/css/app.3f9a1c2e.css"). Filled by StaticFileHandler at startup,
+    // before any worker thread runs, and only read afterwards.
+    class AssetManifest
+    {
+    public:
+        static AssetManifest &Shared();
+
+        // The first root to add a path keeps it.
+        void add(const std::string &path, std::string url);
+
+        // Used for paths that were not fingerprinted: prefix + "/" + path.
+        void setFallbackPrefix(const std::string &prefix);
+
+        std::string url(std::string_view path) const;
+
+        size_t size() const { return urls.size(); }
+
+    private:
+        std::unordered_map<std::string, std::string> urls;
+        std::string fallbackPrefix;
+    };
+}
+
+#endif
@@ -4,7 +4,9 @@
 #include <string>
 #include <functional>
 #include <sstream>
+#include <stdexcept>
 
+#include "Next.hpp"
 #include "Request.hpp"
 #include "Response.hpp"
 
@@ -12,7 +14,19 @@ class IHandler
 {
 public:
     virtual ~IHandler() = default;
-    virtual void Handle(Http::Request &req, Http::Response &res, std::function<void()> next) = 0;
+
+    virtual void Handle(Http::Request &req, Http::Response &res, Next next)
+    {
+        Handle(req, res, std::function<void()>(next));
+    }
+
+    // Handlers written against the std::function continuation still work, at
+    // the cost of wrapping the chain on every call. A handler that overrides
+    // neither overload ends up here and fails instead of passing requests on.
+    virtual void Handle(Http::Request &, Http::Response &, std::function<void()>)
+    {
+        throw std::logic_error("IHandler subclass does not override Handle");
+    }
 };
 
 #endif
\ No newline at end of file
@@ -2,6 +2,7 @@
 #define STATIC_FILE_HANDLER_HPP
 
 #include <fstream>
+#include <memory>
 #include <sys/stat.h>
 #include <unordered_map>
 
@@ -12,17 +13,44 @@ class StaticFileHandler : public IHandler
 public:
     StaticFileHandler(const std::string &basePath);
 
-    virtual void Handle(Http::Request &req, Http::Response &res, std::function<void()> next) override;
+    virtual void Handle(Http::Request &req, Http::Response &res, Next next) override;
 
     static bool SendFile(const std::string& filePath, Http::Response& res);
+
+    // Reads files under basePath into memory, up to maxBytes in total, so they
+    // are served without touching the disk. A file whose size or mtime has
+    // changed since is read from disk again. Call before the server starts.
+    size_t Preload(size_t maxBytes);
+
+    // Hashes every file under basePath and records "<mountPath>/css/app.<hash>.css"
+    // for "css/app.css" in Http::AssetManifest, which {{ asset }} reads. Those
+    // URLs are served with a one-year immutable Cache-Control.
+    size_t Fingerprint(const std::string &mountPath);
     
 private:
+    struct Preloaded
+    {
+        std::shared_ptr<const std::string> content;
+        std::string mimeType;
+        off_t size;
+        struct timespec modified;
+    };
+
     std::string basePath;
     std::unordered_map<std::string, std::string> mimeTypes;
+    std::unordered_map<std::string, Preloaded> preloaded;
+
+    struct Fingerprinted
+    {
+        std::string filePath;
+        off_t size;
+        struct timespec modified;
+    };
+
+    std::unordered_map<std::string, Fingerprinted> fingerprinted;
 
     std::string getMimeType(const std::string &path);
-    bool fileExists(const std::string &path);
-    std::string resolvePath(const std::string &requestPath);
+    std::string resolvePath(std::string_view requestPath);
 };
 
 #endif
\ No newline at end of file
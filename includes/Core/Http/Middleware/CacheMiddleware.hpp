@@ -0,0 +1,25 @@
+#ifndef NERVA_CORE_HTTP_MIDDLEWARE_CACHE_MIDDLEWARE_HPP
+#define NERVA_CORE_HTTP_MIDDLEWARE_CACHE_MIDDLEWARE_HPP
+
+#include <string>
+
+#include "IHandler.hpp"
+#include "ResponseCache.hpp"
+
+// Serves GET responses from a ResponseCache and stores cacheable results of the
+// rest of the chain, keyed by Http::RequestKey.
+class CacheMiddleware : public IHandler
+{
+public:
+    CacheMiddleware(Http::ResponseCache &cache, Http::CacheOptions options);
+
+    virtual void Handle(Http::Request &req, Http::Response &res, Next next) override;
+
+private:
+    Http::ResponseCache &cache;
+    Http::CacheOptions options;
+
+    static bool isCacheable(const Http::Response &res);
+};
+
+#endif
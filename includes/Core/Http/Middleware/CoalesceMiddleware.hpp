@@ -0,0 +1,21 @@
+#ifndef NERVA_CORE_HTTP_MIDDLEWARE_COALESCE_MIDDLEWARE_HPP
+#define NERVA_CORE_HTTP_MIDDLEWARE_COALESCE_MIDDLEWARE_HPP
+
+#include "IHandler.hpp"
+#include "SingleFlight.hpp"
+
+// Runs the rest of a route's chain once for concurrent identical GET/HEAD
+// requests and hands the others a copy of the result. Only safe on routes whose
+// response depends on nothing but the Http::RequestKey.
+class CoalesceMiddleware : public IHandler
+{
+public:
+    explicit CoalesceMiddleware(Http::CoalesceOptions options);
+
+    virtual void Handle(Http::Request &req, Http::Response &res, Next next) override;
+
+private:
+    Http::SingleFlight singleFlight;
+};
+
+#endif
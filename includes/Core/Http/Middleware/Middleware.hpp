@@ -10,12 +10,12 @@
 
 class Middleware : public IHandler
 {
-    std::function<void(Http::Request &req, Http::Response &res, std::function<void()> next)> handler;
+    std::function<void(Http::Request &req, Http::Response &res, Next next)> handler;
 
 public:
-    Middleware(std::function<void(Http::Request &req, Http::Response &res, std::function<void()> next)> handler) : handler(handler) {};
+    Middleware(std::function<void(Http::Request &req, Http::Response &res, Next next)> handler) : handler(handler) {};
 
-    virtual void Handle(Http::Request &req, Http::Response &res, std::function<void()> next)
+    virtual void Handle(Http::Request &req, Http::Response &res, Next next) override
     {
         if (handler)
         {
@@ -0,0 +1,89 @@
+#ifndef CORE_HTTP_REQUEST_ARENA_HPP
+#define CORE_HTTP_REQUEST_ARENA_HPP
+
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace Http
+{
+    // Bump allocator for bytes that live as long as one request. The first
+    // InlineSize bytes are part of the object, so a typical response's
+    // headers never touch the heap. Not copyable or movable: the resource
+    // points into the object itself.
+    class Arena
+    {
+    public:
+        static constexpr size_t InlineSize = 1024;
+
+        Arena() = default;
+        explicit Arena(std::pmr::memory_resource *upstream) : pool(initial, InlineSize, upstream) {}
+        Arena(const Arena &) = delete;
+        Arena &operator=(const Arena &) = delete;
+
+        char *allocate(size_t size)
+        {
+            return static_cast<char *>(pool.allocate(size, 1));
+        }
+
+        std::string_view copy(std::string_view bytes);
+
+        // The parts back to back, as one string in the arena.
+        std::string_view join(std::initializer_list<std::string_view> parts);
+
+        std::pmr::memory_resource *resource() { return &pool; }
+
+        // Frees everything allocated so far; only the inline block remains.
+        void reset() { pool.release(); }
+
+    private:
+        alignas(std::max_align_t) char initial[InlineSize];
+        std::pmr::monotonic_buffer_resource pool{initial, InlineSize};
+    };
+
+    // The memory behind a connection's requests and responses. The request
+    // objects are reused and only cleared in between, so whatever they free
+    // goes back to this pool and is handed out again: once it has served its
+    // largest request, the next ones allocate nothing. Blocks above
+    // LargestPooledBlock (big bodies) come from the heap as usual.
+    class RequestArena
+    {
+    public:
+        static constexpr size_t LargestPooledBlock = 64 * 1024;
+
+        std::pmr::memory_resource *resource() { return &blocks; }
+
+    private:
+        std::pmr::unsynchronized_pool_resource blocks{{0, LargestPooledBlock}};
+    };
+
+    struct StringHash
+    {
+        using is_transparent = void;
+
+        size_t operator()(std::string_view key) const noexcept
+        {
+            return std::hash<std::string_view>{}(key);
+        }
+    };
+
+    struct StringEqual
+    {
+        using is_transparent = void;
+
+        bool operator()(std::string_view a, std::string_view b) const noexcept
+        {
+            return a == b;
+        }
+    };
+
+    // A string-keyed table on a memory resource, searchable by string_view.
+    template <typename T>
+    using StringMap = std::pmr::unordered_map<std::pmr::string, T, StringHash, StringEqual>;
+}
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef CORE_HTTP_REQUEST_BODY_STREAM_HPP
+#define CORE_HTTP_REQUEST_BODY_STREAM_HPP
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "ChunkedDecoder.hpp"
+#include "Task.hpp"
+
+namespace Http
+{
+    // The body of a request on a streaming route. Nothing past what arrived
+    // with the head is read from the connection until the handler asks for
+    // it, so a slow handler holds the client back instead of the body piling
+    // up in memory.
+    class BodyStream
+    {
+    public:
+        // Completes at once when the client has already sent more; otherwise
+        // the handler waits on the event loop, and nothing blocks there.
+        class ReadAwaiter
+        {
+        public:
+            explicit ReadAwaiter(BodyStream &stream) : stream(stream) {}
+
+            bool await_ready();
+            void await_suspend(std::coroutine_handle<> handle);
+            std::string_view await_resume();
+
+        private:
+            // Waits for readiness until a chunk is filled or the body times
+            // out, then resumes reader.
+            Nerva::Detached wait(std::coroutine_handle<> reader);
+
+            BodyStream &stream;
+            std::exception_ptr error;
+        };
+
+        // A body of Content-Length bytes.
+        BodyStream(int socket, size_t length, size_t chunkSize);
+
+        // A chunked body; chunks are decoded in place in the read buffer.
+        BodyStream(int socket, ChunkedDecoder decoder, size_t chunkSize);
+
+        // Takes the body's share of bytes that arrived with the head and
+        // returns its size; the rest belongs to the next request.
+        size_t prime(std::string_view bytes);
+
+        // co_await read() gives the next chunk, valid until the following
+        // read, or an empty view once the whole body has been read. Throws
+        // if the connection ends early.
+        ReadAwaiter read() { return ReadAwaiter(*this); }
+
+        // Content-Length, or 0 for a chunked body.
+        size_t length() const { return length_; }
+        // Body bytes handed to the handler or waiting to be.
+        size_t received() const { return received_; }
+        bool chunked() const { return decoder.has_value(); }
+
+        // Whether the handler read the body to the end; if not, the rest is
+        // still on the connection and it cannot carry another request.
+        bool finished() const { return complete() && chunk.empty(); }
+
+        // Fields sent after the last chunk of a chunked body.
+        const ChunkedDecoder::Fields &trailers() const;
+
+    private:
+        // Receives the next chunk unless one is pending. Returns false when
+        // the client has not sent anything yet.
+        bool fill();
+        std::string_view take();
+        bool complete() const;
+        void decodeBuffered();
+
+        int socket;
+        size_t length_;
+        size_t received_ = 0;
+        std::optional<ChunkedDecoder> decoder;
+
+        // Bytes from start to end of buffer are received but not yet
+        // decoded; chunk is the next one for the handler.
+        std::vector<char> buffer;
+        size_t start = 0;
+        size_t end = 0;
+        std::string_view chunk;
+    };
+}
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef CORE_HTTP_REQUEST_CHUNKED_DECODER_HPP
+#define CORE_HTTP_REQUEST_CHUNKED_DECODER_HPP
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace Http
+{
+    // Incremental decoder for a Transfer-Encoding: chunked body. It takes
+    // input in whatever pieces it arrives in and hands back the chunk data
+    // as views into that input, so the body is never copied to be decoded.
+    class ChunkedDecoder
+    {
+    public:
+        using Fields = std::vector<std::pair<std::string, std::string>>;
+
+        enum class Error
+        {
+            None,
+            Malformed,
+            ChunkTooLarge,
+            TrailersTooLarge,
+        };
+
+        static constexpr size_t MaxLineSize = 4096;
+        static constexpr size_t MaxTrailerSize = 8 * 1024;
+
+        // maxChunkSize of 0 accepts chunks of any size.
+        explicit ChunkedDecoder(size_t maxChunkSize = 0) : maxChunkSize(maxChunkSize) {}
+
+        // Consumes input until it reaches chunk data, the end of the body or
+        // the end of the input, and returns how much it used. Chunk data is
+        // left in data, a view into input; it is empty otherwise.
+        size_t decode(std::string_view input, std::string_view &data);
+
+        // The fewest bytes that can still be left in the body, so a reader
+        // that asks for no more than this never takes bytes past its end.
+        size_t remaining() const;
+
+        bool done() const { return state == State::Done; }
+        bool failed() const { return state == State::Failed; }
+        Error error() const { return error_; }
+
+        // Fields sent after the last chunk; complete once done().
+        const Fields &trailers() const { return trailers_; }
+
+    private:
+        enum class State
+        {
+            Size,
+            Extension,
+            SizeLF,
+            Data,
+            DataCR,
+            DataLF,
+            Trailer,
+            TrailerLF,
+            Done,
+            Failed,
+        };
+
+        void fail(Error error);
+        bool endTrailerLine();
+
+        size_t maxChunkSize;
+        State state = State::Size;
+        Error error_ = Error::None;
+        size_t size = 0;
+        size_t digits = 0;
+        size_t lineSize = 0;
+        size_t trailerSize = 0;
+        std::string line;
+        Fields trailers_;
+    };
+}
+
+#endif
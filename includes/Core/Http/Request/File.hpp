@@ -3,26 +3,51 @@
 
 #include <string>
 #include <string_view>
-#include <fstream>
 #include <vector>
 #include <memory>
+#include <sys/types.h>
+
+#include "SpillFile.hpp"
 
 namespace Http
 {
+    // A view of bytes in shared storage: the request body buffer, a spill
+    // file on disk, or a buffer of its own. Copies and slices share the
+    // storage, so they cost nothing and keep it alive after the request.
+    // A File made from a bare pointer only views it; copying such a File
+    // copies the bytes, as it has no owner to share.
     class File
     {
     public:
-        File(std::string_view content) 
-            : data_(content.data()), size_(content.size()), owned_data_() {}
+        File() : data_(nullptr), size_(0) {}
+
+        File(std::string_view content)
+            : data_(content.data()), size_(content.size()) {}
+
+        File(const char* data, size_t size)
+            : data_(data), size_(size) {}
+
+        // Views data, kept alive by owner.
+        File(std::shared_ptr<const void> owner, const char* data, size_t size)
+            : data_(data), size_(size), owner_(std::move(owner)) {}
+
+        // The whole of a spill file, which must be mapped.
+        explicit File(std::shared_ptr<const SpillFile> spill)
+            : data_(spill->data()), size_(spill->size()), fd_(spill->fd()), owner_(std::move(spill)) {}
 
-        File(const char* data, size_t size) 
-            : data_(data), size_(size), owned_data_() {}
+        // Owns a copy of data.
+        explicit File(const std::vector<char> &data)
+            : File(std::make_shared<const std::vector<char>>(data)) {}
+
+        File(const File& other);
+        File& operator=(const File& other);
 
         File(File&& other) noexcept
-            : data_(other.data_), size_(other.size_), owned_data_(std::move(other.owned_data_))
+            : data_(other.data_), size_(other.size_), fd_(other.fd_), offset_(other.offset_), owner_(std::move(other.owner_))
         {
             other.data_ = nullptr;
             other.size_ = 0;
+            other.fd_ = -1;
         }
 
         File& operator=(File&& other) noexcept
@@ -31,66 +56,17 @@ namespace Http
             {
                 data_ = other.data_;
                 size_ = other.size_;
-                owned_data_ = std::move(other.owned_data_);
-                
+                fd_ = other.fd_;
+                offset_ = other.offset_;
+                owner_ = std::move(other.owner_);
+
                 other.data_ = nullptr;
                 other.size_ = 0;
+                other.fd_ = -1;
             }
             return *this;
         }
 
-        File(const File& other)
-        {
-            if (other.owned_data_)
-            {
-                owned_data_ = std::make_shared<std::vector<char>>(*other.owned_data_);
-                data_ = owned_data_->data();
-                size_ = owned_data_->size();
-            }
-            else
-            {
-                owned_data_ = std::make_shared<std::vector<char>>(other.data_, other.data_ + other.size_);
-                data_ = owned_data_->data();
-                size_ = owned_data_->size();
-            }
-        }
-
-        File& operator=(const File& other)
-        {
-            if (this != &other)
-            {
-                if (other.owned_data_)
-                {
-                    owned_data_ = std::make_shared<std::vector<char>>(*other.owned_data_);
-                    data_ = owned_data_->data();
-                    size_ = owned_data_->size();
-                }
-                else
-                {
-                    owned_data_ = std::make_shared<std::vector<char>>(other.data_, other.data_ + other.size_);
-                    data_ = owned_data_->data();
-                    size_ = owned_data_->size();
-                }
-            }
-            return *this;
-        }
-
-        File() : data_(nullptr), size_(0), owned_data_() {}
-
-        File(const std::string &content) 
-            : owned_data_(std::make_shared<std::vector<char>>(content.begin(), content.end()))
-        {
-            data_ = owned_data_->data();
-            size_ = owned_data_->size();
-        }
-
-        File(const std::vector<char> &data) 
-            : owned_data_(std::make_shared<std::vector<char>>(data))
-        {
-            data_ = owned_data_->data();
-            size_ = owned_data_->size();
-        }
-
         ~File() = default;
 
         size_t size() const { return size_; }
@@ -99,48 +75,45 @@ namespace Http
 
         std::string_view view() const { return std::string_view(data_, size_); }
 
-        std::vector<char> toVector() const 
-        { 
-            return std::vector<char>(data_, data_ + size_); 
-        }
-
-        std::string toString() const 
-        { 
-            return std::string(data_, size_); 
+        std::vector<char> toVector() const
+        {
+            return std::vector<char>(data_, data_ + size_);
         }
 
-        bool save(const std::string &path) const
+        std::string toString() const
         {
-            if (!data_ || size_ == 0)
-                return false;
+            return std::string(data_, size_);
+        }
 
-            std::ofstream outFile(path, std::ios::binary);
-            if (!outFile.is_open())
-                return false;
+        // size bytes from offset, sharing this file's storage.
+        File slice(size_t offset, size_t size) const;
 
-            outFile.write(data_, size_);
-            outFile.close();
-            return true;
-        }
+        // Writes the bytes to path. Content on disk is copied by the kernel
+        // with copy_file_range, without passing through user space.
+        bool save(const std::string &path) const;
 
         bool empty() const { return size_ == 0; }
 
-        bool isOwned() const { return owned_data_ != nullptr; }
+        bool isOwned() const { return owner_ != nullptr; }
+
+        bool onDisk() const { return fd_ != -1; }
 
         void ensureOwned()
         {
-            if (!owned_data_ && data_ && size_ > 0)
-            {
-                owned_data_ = std::make_shared<std::vector<char>>(data_, data_ + size_);
-                data_ = owned_data_->data();
-            }
+            if (!owner_ && data_ && size_ > 0)
+                *this = File(std::vector<char>(data_, data_ + size_));
         }
 
     private:
+        explicit File(std::shared_ptr<const std::vector<char>> bytes)
+            : data_(bytes->data()), size_(bytes->size()), owner_(std::move(bytes)) {}
+
         const char* data_;
         size_t size_;
-        std::shared_ptr<std::vector<char>> owned_data_;
+        int fd_ = -1;
+        off_t offset_ = 0;
+        std::shared_ptr<const void> owner_;
     };
 }
 
-#endif
\ No newline at end of file
+#endif
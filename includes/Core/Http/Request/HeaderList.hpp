@@ -0,0 +1,94 @@
+#ifndef CORE_HTTP_REQUEST_HEADER_LIST_HPP
+#define CORE_HTTP_REQUEST_HEADER_LIST_HPP
+
+#include "Arena.hpp"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Http
+{
+    struct Header
+    {
+        std::string_view name;
+        std::string_view value;
+    };
+
+    // Response headers in insertion order. Names and values are copied into
+    // the list's own arena, and the first InlineCount entries need no
+    // allocation at all; past that, both grow into the upstream resource if
+    // one is given. Copies always use the heap. Names compare
+    // case-insensitively.
+    class HeaderList
+    {
+    public:
+        static constexpr size_t InlineCount = 8;
+
+        HeaderList() = default;
+        explicit HeaderList(std::pmr::memory_resource *upstream) : arena(upstream), overflow(upstream) {}
+        HeaderList(const HeaderList &other);
+        HeaderList &operator=(const HeaderList &other);
+
+        // Replaces the first header with this name, or adds one.
+        void set(std::string_view name, std::string_view value);
+
+        // Adds a header even if the name is present (Set-Cookie).
+        void add(std::string_view name, std::string_view value);
+
+        // Adds a header whose value is the parts joined, built in place.
+        void add(std::string_view name, std::initializer_list<std::string_view> valueParts);
+
+        const Header *find(std::string_view name) const;
+        bool contains(std::string_view name) const { return find(name) != nullptr; }
+
+        // Removes every header with this name; returns how many.
+        size_t erase(std::string_view name);
+        void erase(const Header *header);
+
+        void clear();
+
+        const Header *begin() const { return data(); }
+        const Header *end() const { return data() + count; }
+        size_t size() const { return count; }
+        bool empty() const { return count == 0; }
+
+        // headers["Content-Type"] = "text/css" is set(); reading gives the
+        // value or an empty view.
+        class Slot
+        {
+        public:
+            Slot(HeaderList &list, std::string_view name) : list(list), name(name) {}
+
+            Slot &operator=(std::string_view value)
+            {
+                list.set(name, value);
+                return *this;
+            }
+
+            operator std::string_view() const
+            {
+                const Header *header = list.find(name);
+                return header ? header->value : std::string_view();
+            }
+
+        private:
+            HeaderList &list;
+            std::string_view name;
+        };
+
+        Slot operator[](std::string_view name) { return Slot(*this, name); }
+
+    private:
+        Arena arena;
+        Header inlineHeaders[InlineCount];
+        std::pmr::vector<Header> overflow;
+        size_t count = 0;
+
+        Header *data() { return overflow.empty() ? inlineHeaders : overflow.data(); }
+        const Header *data() const { return overflow.empty() ? inlineHeaders : overflow.data(); }
+        void push(Header header);
+    };
+}
+
+#endif
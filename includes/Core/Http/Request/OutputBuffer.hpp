@@ -0,0 +1,77 @@
+#ifndef CORE_HTTP_REQUEST_OUTPUT_BUFFER_HPP
+#define CORE_HTTP_REQUEST_OUTPUT_BUFFER_HPP
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <sys/uio.h>
+
+namespace Http
+{
+    // Response body held as a list of segments for writev. Small writes are
+    // copied into owned blocks; large spans whose owner is retained (e.g.
+    // compiled template text) are referenced in place.
+    class OutputBuffer
+    {
+    public:
+        static constexpr size_t BlockSize = 4096;
+        static constexpr size_t ReferenceThreshold = 128;
+
+        OutputBuffer() = default;
+        OutputBuffer(const OutputBuffer &other);
+        OutputBuffer &operator=(const OutputBuffer &other);
+        OutputBuffer(OutputBuffer &&) = default;
+        OutputBuffer &operator=(OutputBuffer &&) = default;
+
+        void append(std::string_view bytes);
+
+        // bytes must stay valid while this buffer (or a copy) holds them,
+        // usually by retaining their owner.
+        void reference(std::string_view bytes);
+        void retain(std::shared_ptr<const void> owner);
+
+        size_t size() const { return total; }
+        bool empty() const { return total == 0; }
+
+        // The first segment; enough to look at how the body starts.
+        std::string_view front() const
+        {
+            return segments.empty() ? std::string_view() : std::string_view(segments.front().data, segments.front().size);
+        }
+
+        // Drops the bytes; retained owners live as long as the buffer, since a
+        // streaming render keeps referencing them after each flush.
+        void clear();
+
+        // Empties the buffer for another response: owners are dropped too,
+        // while the segment list keeps its capacity and the first block is
+        // kept for writing unless a copy still shares it.
+        void reset();
+
+        std::string str() const;
+        void gather(std::vector<iovec> &iov) const;
+
+    private:
+        struct Segment
+        {
+            const char *data;
+            size_t size;
+        };
+
+        struct Block
+        {
+            std::shared_ptr<char[]> data;
+            size_t size = 0;
+        };
+
+        std::vector<Segment> segments;
+        std::vector<Block> blocks;
+        std::vector<std::shared_ptr<const void>> owners;
+        char *cursor = nullptr;
+        size_t available = 0;
+        size_t total = 0;
+    };
+}
+
+#endif
@@ -2,15 +2,20 @@
 #define REQUEST_HPP
 
 #include <string>
+#include <string_view>
 #include <map>
+#include <memory_resource>
 #include <unordered_map>
 #include <vector>
+#include <span>
+#include <utility>
 #include <sstream>
 #include <algorithm>
+#include "Arena.hpp"
 #include "File.hpp"
+#include "BodyStream.hpp"
 
 #include <nlohmann/json.hpp>
-#include <sparsehash/dense_hash_map>
 
 namespace Http
 {
@@ -26,57 +31,103 @@ namespace Http
             bool isFile;
         };
 
-        Request(): headers()
+        using String = std::pmr::string;
+
+        // Everything parsed from the request is allocated from resource,
+        // normally the connection's RequestArena, and must not outlive it.
+        explicit Request(std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+            : path(resource), ip(resource), ipv6(resource), headers(resource),
+              formData(resource), params(resource), query(resource)
         {
-            headers.set_empty_key("__EMPTY__");
-            headers.set_deleted_key("__DELETED__");
         }
 
         std::string method;
-        std::string path;
+        String path;
         std::string version;
-        std::string ip;
-        std::string ipv6;
-        std::vector<char> raw_data;
-        google::dense_hash_map<std::string, std::string> headers;
-        std::unordered_map<std::string, FormData> formData;
+        size_t pathOffset = 0;
+        String ip;
+        String ipv6;
+        // The body as received; multipart files are slices of it. Large
+        // bodies live in a spill file instead of memory.
+        File body;
+        // Set instead of body on routes that stream it; see Router::Stream.
+        std::unique_ptr<BodyStream> bodyStream;
+        // Fields that followed a chunked body.
+        ChunkedDecoder::Fields trailers;
+        StringMap<String> headers;
+        StringMap<FormData> formData;
         nlohmann::json jsonBody;
 
-        std::unordered_map<std::string, std::string> params;
-        std::unordered_map<std::string, std::string> query;
+        StringMap<String> params;
+        StringMap<String> query;
+
+        // Segments matched by a typed route's parameters, in pattern order,
+        // given to its handler in place of params. Views into the path,
+        // valid while the route's chain runs.
+        std::span<const std::pair<std::string_view, std::string_view>> captures;
+
+        // rawRequest is exactly one request: the head and its body.
+        bool parse(std::string_view rawRequest);
 
-        bool parse(const std::string &rawRequest);
+        // A head whose body was received separately, e.g. into a SpillFile.
+        bool parse(std::string_view head, File body);
+
+        // Empties the request for the next one on the connection, keeping
+        // the tables' buckets and the strings' capacity. The body buffer is
+        // kept too, unless it is larger than RequestArena::LargestPooledBlock
+        // or a File sliced from it is still around.
+        void reset();
+
+        std::string_view relativePath() const
+        {
+            if (pathOffset >= path.size())
+                return "/";
+            return std::string_view(path).substr(pathOffset);
+        }
 
         bool isMultipartFormData() const;
         bool isUrlEncodedFormData() const;
         bool isJsonData() const;
 
-        const std::string &getParam(const std::string &key) const;
-        const std::string &getQuery(const std::string &key) const;
-        const std::string &getHeader(const std::string &key) const;
+        // Missing keys give an empty view.
+        std::string_view getParam(std::string_view key) const;
+        std::string_view getQuery(std::string_view key) const;
+        std::string_view getHeader(std::string_view key) const;
+        // Of a streamed body, only known once it has been read to the end.
+        std::string_view getTrailer(std::string_view key) const;
+        std::string_view getBody() const { return body.view(); }
+        bool isStreaming() const { return bodyStream != nullptr; }
+        BodyStream &stream() { return *bodyStream; }
         const nlohmann::json &getJson() const;
-        const FormData &getFormData(const std::string &key) const;
+        const FormData &getFormData(std::string_view key) const;
 
-        bool hasParam(const std::string &key) const;
-        bool hasQuery(const std::string &key) const;
-        bool hasHeader(const std::string &key) const;
-        bool hasFormData(const std::string &key) const;
+        void setParam(std::string_view key, std::string_view value);
+
+        bool hasParam(std::string_view key) const;
+        bool hasQuery(std::string_view key) const;
+        bool hasHeader(std::string_view key) const;
+        bool hasFormData(std::string_view key) const;
         bool hasJsonBody() const;
 
     private:
+        std::pmr::memory_resource *resource() const { return headers.get_allocator().resource(); }
+
+        bool parseHead(std::string_view &rest);
+        bool parseBody();
         bool parseMultipartFormData();
-        bool parseFormDataPart(const std::string &headers, const char* content, size_t contentSize);
+        bool parseFormDataPart(std::string_view headers, size_t contentStart, size_t contentSize);
         void parseUrlEncodedFormData();
         void parseJsonData();
         void parseQueryParameters();
 
-        std::vector<std::string> split(const std::string &str, char delim);
-        std::string urlDecode(const std::string &str);
+        std::vector<std::string_view> split(std::string_view str, char delim);
+        String urlDecode(std::string_view str);
 
-        bool matchRouteAndExtractParams(const std::string &routePattern);
+        bool matchRouteAndExtractParams(std::string_view routePattern);
 
+        std::shared_ptr<std::vector<char>> bodyBuffer;
         bool has_json_body = false;
     };
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -10,9 +10,17 @@
 #include <iomanip>
 #include <optional>
 #include <chrono>
+#include <memory>
+#include <functional>
+#include <coroutine>
+#include <vector>
 #include <openssl/hmac.h>
 #include <openssl/evp.h>
 #include "Engine.hpp"
+#include "Completion.hpp"
+#include "Task.hpp"
+#include "OutputBuffer.hpp"
+#include "HeaderList.hpp"
 
 namespace Http
 {
@@ -29,15 +37,80 @@ namespace Http
     class Response
     {
     public:
+        // Only the first this many bytes of a body are inspected when no
+        // Content-Type is set.
+        static constexpr size_t SniffLimit = 512;
+
+        // write() buffers up to this much before sending it as a chunk, and
+        // reports backpressure once this much is left unsent.
+        static constexpr size_t WriteWatermark = 16 * 1024;
+
+        // Resumes a coroutine handler once everything write() left unsent
+        // has gone out; throws if the client went away meanwhile.
+        class DrainAwaiter
+        {
+        public:
+            explicit DrainAwaiter(Response &res) : res(res) {}
+
+            bool await_ready() const { return res.backlog.empty() || res.broken; }
+            void await_suspend(std::coroutine_handle<> handle) { res.drainBacklog(handle); }
+            void await_resume() const;
+
+        private:
+            Response &res;
+        };
+
+        Response() = default;
+
+        // Headers and cookies grow into resource once past their inline
+        // space; the server passes the connection's RequestArena.
+        explicit Response(std::pmr::memory_resource *resource) : headers(resource), incomingCookies(resource) {}
+
         int statusCode = 200;
         std::string statusMessage = "OK";
-        std::unordered_map<std::string, std::string> headers;
+
+        // Set-Cookie lines live here too, one per cookie.
+        HeaderList headers;
+
+        // Sent before output. Prefer <<, which appends to output instead.
         std::string body;
+
+        // The body as a chain of segments: << and template renders append here,
+        // and large owned spans are referenced rather than copied.
+        OutputBuffer output;
         std::string viewDir = "./views";
 
         Nerva::TemplateEngine *_engine;
-        std::unordered_map<std::string, std::string> incomingCookies;
-        std::unordered_map<std::string, std::string> cookies;
+        StringMap<std::pmr::string> incomingCookies;
+
+        // Ready-to-send bytes, e.g. a response cache hit; replaces toString().
+        std::shared_ptr<const std::string> serialized;
+
+        // Installed by the server on HTTP/1.1 connections to write raw bytes.
+        std::function<bool(std::vector<iovec> &)> transport;
+
+        // The client socket, for writes that must not block: write(),
+        // queue() and drain().
+        int connection = -1;
+
+        // True once flush() has sent the head; the rest goes out as chunks.
+        bool streaming = false;
+
+        // True once end() has sent the terminating chunk.
+        bool ended = false;
+
+        // Set by coroutine handlers; the response is complete once it finishes.
+        std::shared_ptr<Nerva::Completion> pending;
+
+        bool isPending() const
+        {
+            return pending && !pending->finished();
+        }
+
+        // Readies the response for the next request on the connection,
+        // keeping what its buffers and tables have grown to. viewDir and
+        // _engine are left as they are.
+        void reset();
 
         void setStatus(int code, const std::string &message)
         {
@@ -45,9 +118,14 @@ namespace Http
             statusMessage = message;
         }
 
-        void setHeader(const std::string &key, const std::string &value)
+        void setHeader(std::string_view key, std::string_view value)
         {
-            headers[key] = value;
+            headers.set(key, value);
+        }
+
+        bool hasCookies() const
+        {
+            return headers.contains("Set-Cookie");
         }
 
         Response &operator<<(int code)
@@ -56,20 +134,51 @@ namespace Http
             return *this;
         }
 
-        Response &operator<<(const std::string &str)
+        Response &operator<<(std::string_view str)
         {
-            body += str;
+            output.append(str);
             return *this;
         }
 
+        // Keeps the string and sends it in place, without copying it.
+        Response &operator<<(std::string &&str)
+        {
+            if (str.size() < OutputBuffer::ReferenceThreshold)
+                return *this << std::string_view(str);
+
+            auto owned = std::make_shared<const std::string>(std::move(str));
+            output.retain(owned);
+            output.reference(*owned);
+            return *this;
+        }
+
+        Response &operator<<(const std::string &str)
+        {
+            return *this << std::string_view(str);
+        }
+
+        Response &operator<<(const char *str)
+        {
+            return *this << std::string_view(str);
+        }
+
         void Render(const std::string view, const nlohmann::json &context)
         {
             _engine->render(*this, view, context);
         }
 
+        // Renders straight from a typed context (a NERVA_REFLECT struct, container
+        // or scalar) without building json; see Value.hpp.
+        template <typename Context>
+        void Render(const std::string view, const Context &context)
+        {
+            _engine->render(*this, view, Nerva::Value::of(context));
+        }
+
         void MovedRedirect(std::string location)
         {
-            body = "";
+            body.clear();
+            output.clear();
 
             statusCode = 301;
             statusMessage = "Moved Permanently";
@@ -79,7 +188,8 @@ namespace Http
 
         void TemporaryRedirect(std::string location)
         {
-            body = "";
+            body.clear();
+            output.clear();
 
             statusCode = 302;
             statusMessage = "Found";
@@ -89,43 +199,16 @@ namespace Http
 
         void SendFile(std::string path);
 
+        // Formats the Set-Cookie line straight into the header arena; setting
+        // a cookie again replaces the earlier line.
         Response &setCookie(const std::string &name,
                             const std::string &value,
-                            const CookieOptions &options = {})
-        {
-            std::ostringstream cookie;
-            cookie << name << "=" << value;
-
-            if (options.maxAge)
-            {
-                cookie << "; Max-Age=" << options.maxAge->count();
-
-                std::time_t expireTime = std::time(nullptr) + options.maxAge->count();
-                std::tm tm = *std::gmtime(&expireTime);
-                char buf[100];
-                std::strftime(buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", &tm);
-                cookie << "; Expires=" << buf;
-            }
-
-            if (options.path)
-                cookie << "; Path=" << *options.path;
-            if (options.domain)
-                cookie << "; Domain=" << *options.domain;
-            if (options.secure)
-                cookie << "; Secure";
-            if (options.httpOnly)
-                cookie << "; HttpOnly";
-            if (options.sameSite)
-                cookie << "; SameSite=" << *options.sameSite;
-
-            cookies[name] = cookie.str();
-            return *this;
-        }
+                            const CookieOptions &options = {});
 
         std::optional<std::string> getCookie(const std::string &name) const
         {
             auto it = incomingCookies.find(name);
-            return it != incomingCookies.end() ? std::make_optional(it->second) : std::nullopt;
+            return it != incomingCookies.end() ? std::make_optional(std::string(it->second)) : std::nullopt;
         }
 
         std::string getCookieValue(const std::string &name,
@@ -177,49 +260,84 @@ namespace Http
             return value.empty() ? "" : std::string(value);
         }
 
-        std::string detectContentType(const std::string &body) const
+        // Guesses from at most SniffLimit bytes at the start of the body.
+        std::string_view detectContentType(std::string_view body) const
         {
+            body = body.substr(0, SniffLimit);
+
             size_t start = body.find_first_not_of(" \t\n\r");
-            if (start == std::string::npos)
+            if (start == std::string_view::npos)
                 return "text/plain";
 
             if (body[start] == '{' || body[start] == '[')
                 return "application/json";
 
-            if (body.find("<html") != std::string::npos || body.find("<!DOCTYPE html") != std::string::npos)
+            if (body.find("<html") != std::string_view::npos || body.find("<!DOCTYPE html") != std::string_view::npos)
                 return "text/html";
 
             return "text/plain";
         }
 
+        std::string head(bool chunked = false) const
+        {
+            std::string head;
+            head.reserve(256);
+            writeHead(head, chunked);
+            return head;
+        }
+
+        // Appends the status line and headers to head.
+        void writeHead(std::string &head, bool chunked = false) const;
+
         std::string toString() const
         {
-            std::ostringstream responseStream;
-            responseStream << "HTTP/1.1 " << statusCode << " " << statusMessage << "\r\n";
+            std::string response = head();
+            response += body;
+            response += output.str();
+            return response;
+        }
 
-            if (headers.find("Content-Type") == headers.end())
-            {
-                responseStream << "Content-Type: " << detectContentType(body) << "\r\n";
-            }
+        // Sends body and output written so far as one chunk, preceded by a
+        // chunked head on the first call. Returns false when the connection
+        // cannot stream or the write fails.
+        bool flush();
 
-            for (const auto &[name, cookie] : cookies)
-            {
-                responseStream << "Set-Cookie: " << cookie << "\r\n";
-            }
+        // Sends anything left and the terminating chunk of a streamed response.
+        bool end();
 
-            for (const auto &[key, val] : headers)
-            {
-                responseStream << key << ": " << val << "\r\n";
-            }
+        // Sends what the socket takes of iov without waiting and keeps the
+        // rest, copied, for drain(). For the event loop thread, which must
+        // not block on a slow reader.
+        void queue(std::vector<iovec> &iov);
 
-            responseStream << "Content-Length: " << body.size() << "\r\n";
-            responseStream << "Connection: keep-alive" << "\r\n\r\n";
-            responseStream << body;
+        // end() through queue(): the rest of a streamed response and its
+        // terminating chunk go out with co_await drain().
+        void queueEnd();
 
-            return responseStream.str();
-        }
+        // Appends chunk to a streamed response. The first write sends the
+        // head right away; later ones go out once WriteWatermark bytes have
+        // built up. Never blocks: what the socket does not take is kept, and
+        // false means the caller should wait for it, with co_await drain()
+        // in a coroutine handler or flush() in a plain one. Without a
+        // transport (HTTP/1.0) the body is just buffered.
+        bool write(std::string_view chunk);
+
+        DrainAwaiter drain() { return DrainAwaiter(*this); }
 
     private:
+        // Adds the next chunk to iov: the head first if nothing was sent
+        // yet, then the size line, built in prefix, and the buffered body.
+        void frame(std::string &prefix, std::vector<iovec> &iov);
+
+        bool sendChunk();
+        void sendBacklog();
+        Nerva::Detached drainBacklog(std::coroutine_handle<> waiter);
+
+        // Framed bytes the socket would not take yet; sent before anything
+        // else.
+        std::string backlog;
+        bool broken = false;
+
         static std::string hmac_sha256(const std::string &key, const std::string &data)
         {
             unsigned char digest[EVP_MAX_MD_SIZE];
@@ -230,13 +348,14 @@ namespace Http
                  reinterpret_cast<const unsigned char *>(data.c_str()), data.length(),
                  digest, &len);
 
-            std::ostringstream oss;
+            static const char digits[] = "0123456789abcdef";
+            std::string hex(len * 2, '0');
             for (unsigned int i = 0; i < len; i++)
             {
-                oss << std::hex << std::setw(2) << std::setfill('0')
-                    << static_cast<int>(digest[i]);
+                hex[i * 2] = digits[digest[i] >> 4];
+                hex[i * 2 + 1] = digits[digest[i] & 0xf];
             }
-            return oss.str();
+            return hex;
         }
     };
 }
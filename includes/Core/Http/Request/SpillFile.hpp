@@ -0,0 +1,40 @@
+#ifndef CORE_HTTP_REQUEST_SPILL_FILE_HPP
+#define CORE_HTTP_REQUEST_SPILL_FILE_HPP
+
+#include <cstddef>
+#include <memory>
+
+namespace Http
+{
+    // A request body too large to keep in memory, written to an unnamed
+    // temporary file as it arrives and then mapped for reading. Files sliced
+    // from it share it, and save() copies from it inside the kernel.
+    class SpillFile
+    {
+    public:
+        // A new empty file in the temporary directory, or null.
+        static std::shared_ptr<SpillFile> Create();
+
+        ~SpillFile();
+        SpillFile(const SpillFile &) = delete;
+        SpillFile &operator=(const SpillFile &) = delete;
+
+        bool append(const char *bytes, size_t count);
+
+        // Maps what was written; call once, after the last append.
+        bool map();
+
+        int fd() const { return descriptor; }
+        const char *data() const { return mapping; }
+        size_t size() const { return written; }
+
+    private:
+        explicit SpillFile(int descriptor) : descriptor(descriptor) {}
+
+        int descriptor;
+        char *mapping = nullptr;
+        size_t written = 0;
+    };
+}
+
+#endif
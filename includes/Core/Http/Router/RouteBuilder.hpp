@@ -9,6 +9,8 @@
 
 #include "Handlers.hpp"
 #include "IHandler.hpp"
+#include "ResponseCache.hpp"
+#include "SingleFlight.hpp"
 
 class Router;
 
@@ -17,10 +19,19 @@ class RouteBuilder
 public:
     RouteBuilder(Router &router, std::string method, std::string path);
     RouteBuilder &Use(IHandler &middleware);
+    RouteBuilder &Cache(const Http::CacheOptions &options);
+    // Concurrent identical GET/HEAD requests share one run of the rest of the
+    // chain. Use it only where the response depends on nothing outside the key.
+    RouteBuilder &Coalesce(const Http::CoalesceOptions &options = {});
+    // The handler runs once the head arrives and reads the body itself,
+    // chunk by chunk, from req.stream().
+    RouteBuilder &Stream();
     void Then(RequestHandler handler);
+    void Then(AsyncHandler handler);
 
 private:
     Router &router;
     std::string method, path;
     std::vector<std::reference_wrapper<IHandler>> middlewares;
+    bool streaming = false;
 };
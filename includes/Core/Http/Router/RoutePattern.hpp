@@ -0,0 +1,244 @@
+#ifndef ROUTE_PATTERN_HPP
+#define ROUTE_PATTERN_HPP
+
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "Handlers.hpp"
+
+namespace Http
+{
+    // String literal usable as a template argument, e.g. Get<"/users/{id:int}">.
+    template <size_t N>
+    struct RoutePattern
+    {
+        char value[N]{};
+
+        consteval RoutePattern(const char (&str)[N])
+        {
+            for (size_t i = 0; i < N; ++i)
+                value[i] = str[i];
+        }
+
+        constexpr std::string_view view() const { return std::string_view(value, N - 1); }
+    };
+
+    enum class RouteParamType
+    {
+        String,
+        Int,
+        Long,
+        UInt,
+        Double
+    };
+
+    struct RouteParam
+    {
+        RouteParamType type = RouteParamType::String;
+    };
+
+    template <RouteParamType T>
+    struct RouteParamValue
+    {
+        using type = std::string_view;
+    };
+
+    template <>
+    struct RouteParamValue<RouteParamType::Int>
+    {
+        using type = int;
+    };
+
+    template <>
+    struct RouteParamValue<RouteParamType::Long>
+    {
+        using type = long long;
+    };
+
+    template <>
+    struct RouteParamValue<RouteParamType::UInt>
+    {
+        using type = unsigned long long;
+    };
+
+    template <>
+    struct RouteParamValue<RouteParamType::Double>
+    {
+        using type = double;
+    };
+
+    template <typename T>
+    bool convertRouteParam(std::string_view text, T &out)
+    {
+        if constexpr (std::is_same_v<T, std::string_view>)
+        {
+            out = text;
+            return true;
+        }
+        else
+        {
+            const char *end = text.data() + text.size();
+            auto [ptr, ec] = std::from_chars(text.data(), end, out);
+            return ec == std::errc() && ptr == end;
+        }
+    }
+
+    // Parses a pattern such as "/users/{id:int}/posts/{slug}" at compile time.
+    // Parameter types are int, long, uint, double and str (the default).
+    template <RoutePattern P>
+    class TypedRoute
+    {
+        static constexpr std::string_view pattern = P.view();
+
+        static constexpr RouteParamType parseType(std::string_view type)
+        {
+            if (type.empty() || type == "str" || type == "string")
+                return RouteParamType::String;
+            if (type == "int")
+                return RouteParamType::Int;
+            if (type == "long")
+                return RouteParamType::Long;
+            if (type == "uint")
+                return RouteParamType::UInt;
+            if (type == "double" || type == "float")
+                return RouteParamType::Double;
+            throw "unknown route parameter type";
+        }
+
+        template <typename Visitor>
+        static constexpr void forEachSegment(Visitor visit)
+        {
+            size_t index = 0;
+            size_t pos = 0;
+            while (pos < pattern.size())
+            {
+                size_t end = pattern.find('/', pos);
+                if (end == std::string_view::npos)
+                    end = pattern.size();
+
+                if (end > pos)
+                    visit(index++, pattern.substr(pos, end - pos));
+
+                pos = end + 1;
+            }
+        }
+
+        static consteval size_t countParams()
+        {
+            size_t count = 0;
+            forEachSegment([&](size_t, std::string_view seg)
+                           {
+                if (seg.front() == '{')
+                    ++count; });
+            return count;
+        }
+
+    public:
+        static constexpr size_t paramCount = countParams();
+
+    private:
+        static consteval std::array<RouteParam, paramCount> parseParams()
+        {
+            std::array<RouteParam, paramCount> params{};
+            size_t n = 0;
+            forEachSegment([&](size_t, std::string_view seg)
+                           {
+                if (seg.front() != '{')
+                    return;
+                if (seg.back() != '}')
+                    throw "unterminated route parameter";
+
+                size_t colon = seg.find(':');
+                std::string_view type = colon == std::string_view::npos
+                                            ? std::string_view()
+                                            : seg.substr(colon + 1, seg.size() - colon - 2);
+                params[n++] = RouteParam{parseType(type)}; });
+            return params;
+        }
+
+        // The same route in the ":name" form RadixNode understands.
+        static consteval std::array<char, pattern.size() + 1> buildRadixPath()
+        {
+            std::array<char, pattern.size() + 1> out{};
+            size_t len = 0;
+            forEachSegment([&](size_t, std::string_view seg)
+                           {
+                out[len++] = '/';
+                if (seg.front() == '{')
+                {
+                    size_t nameEnd = seg.find(':');
+                    if (nameEnd == std::string_view::npos)
+                        nameEnd = seg.size() - 1;
+                    out[len++] = ':';
+                    for (size_t i = 1; i < nameEnd; ++i)
+                        out[len++] = seg[i];
+                }
+                else
+                {
+                    for (char c : seg)
+                        out[len++] = c;
+                } });
+            if (len == 0)
+                out[len++] = '/';
+            return out;
+        }
+
+        static constexpr auto params = parseParams();
+        static constexpr auto radixStorage = buildRadixPath();
+
+        template <size_t I>
+        using ParamT = typename RouteParamValue<params[I].type>::type;
+
+        template <typename F, size_t... I>
+        static void invoke(const F &handler, const Http::Request &req, Http::Response &res, NextFunction next,
+                           std::index_sequence<I...>)
+        {
+            std::tuple<ParamT<I>...> values;
+            if (!(convertRouteParam(req.captures[I].second, std::get<I>(values)) && ...))
+            {
+                res.setStatus(404, "Not Found");
+                return;
+            }
+
+            if constexpr (std::is_invocable_v<const F &, const Http::Request &, Http::Response &, NextFunction, ParamT<I>...>)
+            {
+                handler(req, res, next, std::get<I>(values)...);
+            }
+            else
+            {
+                handler(req, res, std::get<I>(values)...);
+            }
+        }
+
+    public:
+        static std::string radixPath()
+        {
+            return std::string(radixStorage.data());
+        }
+
+        // The router hands a typed route the values it captured while
+        // matching (Request::captures), so they are converted in place.
+        template <typename F>
+        static RequestHandler wrap(F handler)
+        {
+            return [handler = std::move(handler)](const Http::Request &req, Http::Response &res, NextFunction next)
+            {
+                if (req.captures.size() != paramCount)
+                {
+                    res.setStatus(404, "Not Found");
+                    return;
+                }
+
+                invoke(handler, req, res, next, std::make_index_sequence<paramCount>{});
+            };
+        }
+    };
+}
+
+#endif
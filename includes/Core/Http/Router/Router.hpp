@@ -11,6 +11,8 @@
 #include "Handlers.hpp"
 #include "String.hpp"
 #include "RadixNode.hpp"
+#include "MountTrie.hpp"
+#include "RoutePattern.hpp"
 #include "IHandler.hpp"
 #include "NervaEngine.hpp"
 
@@ -25,6 +27,14 @@ public:
 
     void addRoute(const std::vector<std::reference_wrapper<IHandler>> &middlewares, const std::string &method, const std::string &path, const RequestHandler &handler);
 
+    // Requests to this route are handed over as soon as their head arrives,
+    // with the body left on the connection behind req.stream().
+    void addStreamingRoute(const std::string &method, const std::string &path);
+
+    // Whether a request for path is routed to a streaming route, here or in
+    // a group mounted on this router.
+    bool streamsBody(const std::string &method, std::string_view path) const;
+
     void Get(const std::string &path, std::vector<std::reference_wrapper<IHandler>> middlewares, const RequestHandler &handler);
     void Post(const std::string &path, std::vector<std::reference_wrapper<IHandler>> middlewares, const RequestHandler &handler);
     void Put(const std::string &path, std::vector<std::reference_wrapper<IHandler>> middlewares, const RequestHandler &handler);
@@ -35,6 +45,54 @@ public:
     RouteBuilder Put(const std::string path);
     RouteBuilder Delete(const std::string path);
 
+    template <Http::RoutePattern Pattern, typename F>
+    void Get(F handler)
+    {
+        addTypedRoute<Pattern>({}, "GET", std::move(handler));
+    }
+
+    template <Http::RoutePattern Pattern, typename F>
+    void Get(std::vector<std::reference_wrapper<IHandler>> middlewares, F handler)
+    {
+        addTypedRoute<Pattern>(middlewares, "GET", std::move(handler));
+    }
+
+    template <Http::RoutePattern Pattern, typename F>
+    void Post(F handler)
+    {
+        addTypedRoute<Pattern>({}, "POST", std::move(handler));
+    }
+
+    template <Http::RoutePattern Pattern, typename F>
+    void Post(std::vector<std::reference_wrapper<IHandler>> middlewares, F handler)
+    {
+        addTypedRoute<Pattern>(middlewares, "POST", std::move(handler));
+    }
+
+    template <Http::RoutePattern Pattern, typename F>
+    void Put(F handler)
+    {
+        addTypedRoute<Pattern>({}, "PUT", std::move(handler));
+    }
+
+    template <Http::RoutePattern Pattern, typename F>
+    void Put(std::vector<std::reference_wrapper<IHandler>> middlewares, F handler)
+    {
+        addTypedRoute<Pattern>(middlewares, "PUT", std::move(handler));
+    }
+
+    template <Http::RoutePattern Pattern, typename F>
+    void Delete(F handler)
+    {
+        addTypedRoute<Pattern>({}, "DELETE", std::move(handler));
+    }
+
+    template <Http::RoutePattern Pattern, typename F>
+    void Delete(std::vector<std::reference_wrapper<IHandler>> middlewares, F handler)
+    {
+        addTypedRoute<Pattern>(middlewares, "DELETE", std::move(handler));
+    }
+
     void Group(const std::string &path, std::vector<std::reference_wrapper<IHandler>> middlewares, GroupHandler handler);
 
     GroupBuilder Group(const std::string path);
@@ -47,14 +105,22 @@ public:
 
     void Use(const std::string &path, IHandler &handler)
     {
+        mounts.insert(path, handlers.size(), &handler);
         handlers.push_back({path, std::unique_ptr<IHandler>(&handler)});
     }
 
     void Use(const std::string &path, std::unique_ptr<IHandler> handler)
     {
+        mounts.insert(path, handlers.size(), handler.get());
         handlers.push_back({path, std::move(handler)});
     }
 
+    IHandler &ownHandler(std::unique_ptr<IHandler> handler)
+    {
+        ownedHandlers.push_back(std::move(handler));
+        return *ownedHandlers.back();
+    }
+
     UniqueRouter operator[](std::string request_type)
     {
         return UniqueRouter{request_type, this};
@@ -62,19 +128,29 @@ public:
 
     bool dispatch(Http::Request &req, Http::Response &res, const std::string &basePath = "") const;
 
-    virtual void Handle(Http::Request &req, Http::Response &res, std::function<void()> next) override;
+    virtual void Handle(Http::Request &req, Http::Response &res, Next next) override;
 
 private:
+    template <Http::RoutePattern Pattern, typename F>
+    void addTypedRoute(const std::vector<std::reference_wrapper<IHandler>> &middlewares, const std::string &method, F handler)
+    {
+        using Route = Http::TypedRoute<Pattern>;
+        routes.insert(middlewares, method, Route::radixPath(), Route::wrap(std::move(handler)), true);
+    }
+
     std::string makeKey(const std::string &method, const std::string &path) const
     {
         return method + ":" + path;
     }
 
-    bool tryDispatch(const std::string &fullPath, Http::Request &req, Http::Response &res) const;
+    bool tryDispatch(std::string_view fullPath, Http::Request &req, Http::Response &res) const;
 
     RadixNode routes;
+    RadixNode streamingRoutes;
+    MountTrie mounts;
 
     std::vector<std::pair<std::string, std::unique_ptr<IHandler>>> handlers;
+    std::vector<std::unique_ptr<IHandler>> ownedHandlers;
 };
 
 #endif
@@ -3,15 +3,20 @@
 
 #include <atomic>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <thread>
+#include <memory>
 #include <netinet/in.h>
 #include <sys/epoll.h>
+#include <sys/uio.h>
 
 #include "ConfigParser.hpp"
 #include "ThreadSafeQueue.hpp"
 #include "Router.hpp"
 #include "StaticFileHandler.hpp"
+#include "OffloadPool.hpp"
+#include "Task.hpp"
 
 class Server : public Router
 {
@@ -25,11 +30,30 @@ public:
     void Static(const std::string &path, const std::string &directory)
     {
         auto handler = new StaticFileHandler(directory);
+        staticHandlers.emplace_back(path, handler);
         Use(path, *handler);
     }
 
     void SetConfigFile(std::string path);
 
+    // Runs blocking work on the offload pool; see Nerva::Offload.
+    template <typename F>
+    auto Offload(F &&fn)
+    {
+        return Nerva::Offload(std::forward<F>(fn));
+    }
+
+    template <typename F>
+    bool Offload(F &&fn, std::function<void(std::exception_ptr)> done)
+    {
+        return Nerva::Offload(std::forward<F>(fn), std::move(done));
+    }
+
+    Nerva::OffloadPool::Stats OffloadStats()
+    {
+        return Nerva::OffloadPool::Shared().stats();
+    }
+
     static int initSocket(int port, int listenQueueSize);
 
 private:
@@ -48,11 +72,55 @@ private:
     ThreadSafeQueue socketQueue;
     std::atomic<int> activeConnections;
 
+    std::vector<std::pair<std::string, StaticFileHandler *>> staticHandlers;
+
     std::vector<std::thread> acceptThreads;
     std::vector<std::thread> threadPool;
 
+    // Lets a suspended coroutine handler release its worker thread; only set
+    // when a thread pool exists to hand the connection back to.
+    bool parkSuspended = false;
+
+    // A request and its response, reused by a worker thread from one request
+    // to the next.
+    struct Exchange
+    {
+        // First, so it outlives req and res.
+        Http::RequestArena arena;
+        Http::Request req{arena.resource()};
+        Http::Response res{arena.resource()};
+
+        // Scratch for sendResponse.
+        std::string head;
+        std::vector<iovec> iov;
+
+        void reset()
+        {
+            req.reset();
+            res.reset();
+        }
+
+        // False when a streaming handler left part of the body unread.
+        bool drained()
+        {
+            return !req.isStreaming() || req.stream().finished();
+        }
+    };
+
     void acceptConnections();
     void handleClient(int clientSocket);
+    static void gatherResponse(Exchange &exchange);
+    void sendResponse(int clientSocket, Exchange &exchange);
+    bool routesToStream(std::string_view head) const;
+    static void rejectRequest(int clientSocket, std::string_view status);
+    static ssize_t receiveBody(int clientSocket, std::vector<char> &buffer);
+    Http::File spillBody(int clientSocket, std::string &requestData, size_t bodyStart, size_t contentLength, std::vector<char> &buffer);
+    bool readChunkedBody(int clientSocket, std::string &requestData, size_t bodyStart, Http::ChunkedDecoder &decoder,
+                         std::vector<char> &buffer, size_t spillSize, Http::File &body);
+    static bool sendAll(int clientSocket, std::vector<iovec> &iov);
+    bool park(int clientSocket, std::shared_ptr<Exchange> exchange, bool keepAlive);
+    Nerva::Detached finishParked(int clientSocket, std::shared_ptr<Exchange> exchange, bool keepAlive);
+    void WarmUp();
     void StartWorker();
     void StartSingleThreaded();
     static int SetNonBlocking(int fd);
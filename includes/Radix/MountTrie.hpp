@@ -0,0 +1,44 @@
+#ifndef MOUNTTRIE_HPP
+#define MOUNTTRIE_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+
+#include "IHandler.hpp"
+
+// Prefix trie over the paths handed to Router::Use. A single walk over the
+// request path yields every mount that applies to it, in registration order.
+class MountTrie
+{
+public:
+    struct Mount
+    {
+        size_t order;
+        size_t prefixLength;
+        bool wildcard;
+        IHandler *handler;
+    };
+
+    MountTrie();
+    ~MountTrie();
+
+    void insert(const std::string &path, size_t order, IHandler *handler);
+    void match(std::string_view path, std::vector<Mount> &matches) const;
+
+private:
+    struct Node
+    {
+        std::string edge;
+        std::vector<std::unique_ptr<Node>> children;
+        std::vector<Mount> mounts;
+    };
+
+    Node root;
+    std::vector<Mount> wildcardMounts;
+
+    static size_t commonPrefix(std::string_view a, std::string_view b);
+};
+
+#endif
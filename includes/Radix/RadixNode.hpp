@@ -2,6 +2,7 @@
 #define RADIXNODE_HPP
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
 #include <memory>
@@ -14,26 +15,33 @@
 class RadixNode
 {
 public:
+    using Params = std::vector<std::pair<std::string_view, std::string_view>>;
+
     explicit RadixNode(std::string segment = "");
     ~RadixNode();
 
-    void insert(const std::vector<std::reference_wrapper<IHandler>> &middlewares, const std::string &method, const std::string &path, const RequestHandler &handler);
-    std::optional<std::pair<RequestHandler, std::vector<std::reference_wrapper<IHandler>>>> find(const std::string &method, const std::string &path, std::map<std::string, std::string> &params) const;
-    std::vector<RequestHandler> getAllHandlers(const std::string &method, const std::string &path) const;
+    // A typed handler reads its parameters from Request::captures rather
+    // than Request::params.
+    void insert(const std::vector<std::reference_wrapper<IHandler>> &middlewares, const std::string &method, const std::string &path, const RequestHandler &handler, bool typed = false);
+    // typed, if given, is set when every handler of the match is typed.
+    std::optional<std::pair<RequestHandler, std::vector<std::reference_wrapper<IHandler>>>> find(const std::string &method, std::string_view path, Params &params, bool *typed = nullptr) const;
+    std::vector<RequestHandler> getAllHandlers(const std::string &method, std::string_view path) const;
 
 private:
     std::string segment;
     std::vector<std::unique_ptr<RadixNode>> children;
     std::map<std::string, std::vector<RequestHandler>> methodHandlers;
     std::unordered_map<std::string, std::vector<std::reference_wrapper<IHandler>>> methodMiddlewares;
+    std::map<std::string, bool> methodTyped;
 
+    bool isTyped(const std::string &method) const;
     bool isParam() const;
     bool isWildcard() const;
-    RadixNode *findChild(const std::string &seg) const;
+    RadixNode *findChild(std::string_view seg) const;
     RadixNode *findParamChild() const;
     RadixNode *findWildcardChild() const;
 
-    static std::vector<std::string> split(const std::string &path);
+    static std::vector<std::string_view> split(std::string_view path);
 };
 
 #endif
@@ -5,13 +5,17 @@
 #include <map>
 #include <functional>
 
+#include "Next.hpp"
+#include "Task.hpp"
 #include "Request.hpp"
 #include "Response.hpp"
 
 class Router;
 
-using NextFunction = std::function<void()>;
+using NextFunction = Next;
 using RequestHandler = std::function<void(const Http::Request&, Http::Response&, NextFunction)>;
+// Coroutine handler; the response is sent once the returned task finishes.
+using AsyncHandler = std::function<Nerva::Task<void>(Http::Request&, Http::Response&)>;
 using GroupHandler = std::function<void(Router&)>;
 
 #endif
\ No newline at end of file
@@ -0,0 +1,43 @@
+#ifndef NEXT_HPP
+#define NEXT_HPP
+
+#include <memory>
+#include <type_traits>
+
+// Non-owning reference to the rest of a handler chain. It is two pointers wide
+// and never allocates, so the callable it refers to must outlive it.
+class Next
+{
+public:
+    Next() noexcept : object(nullptr), invoke(&noop) {}
+
+    template <typename F>
+        requires(!std::is_same_v<std::decay_t<F>, Next> && std::is_invocable_v<F &> &&
+                 std::is_lvalue_reference_v<F>)
+    Next(F &&fn) noexcept
+        : object(const_cast<void *>(static_cast<const void *>(std::addressof(fn)))),
+          invoke([](void *obj)
+                 { (*static_cast<std::remove_reference_t<F> *>(obj))(); })
+    {
+    }
+
+    // A temporary would be gone by the time the chain calls it, so only a
+    // named callable can be bound.
+    template <typename F>
+        requires(!std::is_same_v<std::decay_t<F>, Next> && std::is_invocable_v<F &> &&
+                 !std::is_lvalue_reference_v<F>)
+    Next(F &&) = delete;
+
+    void operator()() const
+    {
+        invoke(object);
+    }
+
+private:
+    void *object;
+    void (*invoke)(void *);
+
+    static void noop(void *) {}
+};
+
+#endif
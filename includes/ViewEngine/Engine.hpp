@@ -2,9 +2,20 @@
 #define ENGINE_HPP
 
 #include "NervaEngine.hpp"
+#include "Template.hpp"
+#include "TemplateCache.hpp"
+#include "Filters.hpp"
+#include "OutputBuffer.hpp"
+#include "ResponseCache.hpp"
 
 #include <string>
-#include <map>
+#include <string_view>
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <sys/types.h>
 #include <filesystem>
 
 namespace Nerva
@@ -12,25 +23,97 @@ namespace Nerva
     class Engine : public TemplateEngine
     {
     public:
+        // Variable lookup chain; frames reference the caller's data, so loops and
+        // includes bind names without copying any part of the context.
+        struct Scope
+        {
+            const Scope *parent = nullptr;
+            Value object;
+            std::string_view name;
+            Value value;
+
+            // Named frames leave object missing.
+            Value find(const std::string &key) const;
+        };
+
+        struct Output
+        {
+            Http::OutputBuffer &buffer;
+            Http::Response *stream = nullptr;
+            size_t flushAt = 0;
+
+            // Call only while stream is set.
+            void flushIfFull();
+        };
+
+        Engine();
+        ~Engine();
+
         void setViewsDirectory(const std::string &path);
-        void render(Http::Response &res, const std::string &templateName, const json &context) override;
+
+        // Recompiles cached views when their files change (inotify on the views
+        // directory) and renders from source even where a compiled view is
+        // linked in. The watcher starts with the first render in each process.
+        void setHotReload(bool enabled);
+
+        // Renders over this many bytes are sent as chunked transfer-encoding
+        // while rendering continues, on connections that allow it. 0 disables.
+        // Renders on the event loop thread (coroutine handlers after their
+        // first co_await) are never streamed.
+        void setStreamThreshold(size_t bytes);
+
+        // Byte budget for {{ cache }} fragments, shared by all views.
+        void setFragmentCacheSize(size_t bytes);
+
+        // function(value, arguments) for {{ x | name:arg1,arg2 }}. Filters are bound
+        // when a template is compiled, so compiled views are dropped and rebuilt.
+        // Throws std::logic_error once warmUp() or render() has run.
+        void RegisterFilter(const std::string &name, FilterFunction function);
+
+        void render(Http::Response &res, const std::string &templateName, const Value &context) override;
+
+        // Compiles every .html view that has no compiled counterpart (all of
+        // them with hot reload on). Does not start the reload watcher.
+        size_t warmUp() override;
+
+        // Entry points for views compiled ahead of time (ViewRuntime.hpp).
+        void include(const std::string &templateName, const Scope &scope, Output &out);
+        Http::ResponseCache::Bytes findFragment(const std::string &key);
+        Http::ResponseCache::Bytes storeFragment(const std::string &key, int ttl, const Http::OutputBuffer &fragment);
 
     private:
         std::filesystem::path viewsDir;
-        std::map<std::string, std::string> templateCache;
-
-        std::string loadTemplate(const std::string &templateName);
-        std::string renderString(const std::string &content, const json &context);
-        std::string processForLoop(const std::string &loopExpr,
-                                   const std::string &loopContent,
-                                   const json &context);
-        std::string processIfCondition(const std::string &ifExpr,
-                                       const std::string &ifContent,
-                                       const json &context);
-        std::string evaluateExpression(const std::string &expr,
-                                       const json &context);
-        json resolvePath(const std::string &path, const json &data);
+        TemplateCache templates;
+        FilterRegistry filters;
+        Http::ResponseCache fragments{16 * 1024 * 1024};
+        std::vector<FilterFunction> compiledFilters;
+        std::string unboundFilter;
+
+        size_t streamThreshold = 0;
+        std::atomic<bool> sealed{false};
+        bool hotReload = false;
+        std::mutex watcherMtx;
+        pid_t watcherPid = 0;
+        std::unique_ptr<std::thread> watcher;
+        std::atomic<bool> stopWatching{false};
+
+        std::shared_ptr<const CompiledTemplate> loadTemplate(const std::string &templateName);
+        std::shared_ptr<const CompiledTemplate> compileFile(const std::string &templateName);
+
+        void bindCompiledFilters();
+        void checkCompiledFilters() const;
+        void ensureWatcher();
+        void watchViews();
+
+        void execute(const std::vector<Node> &nodes, const Scope &scope, Output &out);
+        void executeFor(const Node &node, const Scope &scope, Output &out);
+        void executeInclude(const Node &node, const Scope &scope, Output &out);
+        void executeCache(const Node &node, const Scope &scope, Output &out);
+
+        bool test(const Condition &condition, const Scope &scope);
+        Value evaluate(const Expression &expr, const Scope &scope, json &storage);
+        Value resolvePath(const std::vector<PathSegment> &path, const Scope &scope, json &storage);
     };
 }
 
-#endif
\ No newline at end of file
+#endif
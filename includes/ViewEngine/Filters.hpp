@@ -0,0 +1,33 @@
+#ifndef NERVA_FILTERS_HPP
+#define NERVA_FILTERS_HPP
+
+#include "Template.hpp"
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace Nerva
+{
+    // Name -> function table consulted when templates are compiled. Starts
+    // with the built-in filters; registering a name again replaces it.
+    class FilterRegistry
+    {
+    public:
+        FilterRegistry();
+
+        void add(const std::string &name, FilterFunction function);
+        FilterFunction find(const std::string &name) const;
+
+    private:
+        std::unordered_map<std::string, FilterFunction> functions;
+    };
+
+    // Shortest text that reads back as the same number.
+    std::string_view formatNumber(const json &value, char (&buffer)[32]);
+
+    // Text form of a scalar as it is printed; empty for null, arrays and objects.
+    std::string toText(const json &value);
+}
+
+#endif
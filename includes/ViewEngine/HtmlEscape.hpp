@@ -0,0 +1,18 @@
+#ifndef NERVA_HTML_ESCAPE_HPP
+#define NERVA_HTML_ESCAPE_HPP
+
+#include "OutputBuffer.hpp"
+
+#include <string_view>
+
+namespace Nerva
+{
+    // Position of the first of & < > " ' at or after from, or text.size().
+    size_t findHtmlSpecial(std::string_view text, size_t from = 0);
+
+    // Appends text with & < > " ' replaced by entities. Runs without those
+    // characters are copied in one append.
+    void appendEscaped(std::string_view text, Http::OutputBuffer &out);
+}
+
+#endif
@@ -1,7 +1,7 @@
 #ifndef NERVA_ENGINE_HPP
 #define NERVA_ENGINE_HPP
 
-#include <nlohmann/json.hpp>
+#include "Value.hpp"
 
 #include <string>
 #include <memory>
@@ -13,13 +13,15 @@ namespace Http
 
 namespace Nerva
 {
-    using json = nlohmann::json;
-
     class TemplateEngine
     {
     public:
         virtual ~TemplateEngine() = default;
-        virtual void render(Http::Response &res, const std::string &templateName, const json &context) = 0;
+        virtual void render(Http::Response &res, const std::string &templateName, const Value &context) = 0;
+
+        // Loads every view up front; returns how many. Called by the server
+        // before it forks so workers share the result copy-on-write.
+        virtual size_t warmUp() { return 0; }
     };
 }
 
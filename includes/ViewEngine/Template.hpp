@@ -0,0 +1,116 @@
+#ifndef NERVA_TEMPLATE_HPP
+#define NERVA_TEMPLATE_HPP
+
+#include "NervaEngine.hpp"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Nerva
+{
+    struct PathSegment
+    {
+        std::string key;
+        size_t index = 0;
+        bool isIndex = false;
+    };
+
+    using FilterArguments = std::vector<json>;
+    using FilterFunction = json (*)(const json &value, const FilterArguments &arguments);
+
+    class FilterRegistry;
+
+    // name:arg1,arg2 with literal arguments; function is looked up when the
+    // template is compiled and stays null for unknown names.
+    struct Filter
+    {
+        std::string name;
+        FilterArguments arguments;
+        FilterFunction function = nullptr;
+    };
+
+    // A context path such as user.name or username[0], or a literal, followed
+    // by its filters. raw is set by a |raw filter and skips HTML escaping.
+    struct Expression
+    {
+        std::vector<PathSegment> path;
+        json literal;
+        bool isLiteral = false;
+        bool raw = false;
+        std::vector<Filter> filters;
+    };
+
+    struct Condition
+    {
+        enum class Op
+        {
+            Truthy,
+            Equal,
+            NotEqual,
+            Less,
+            LessEqual,
+            Greater,
+            GreaterEqual
+        };
+
+        bool negate = false;
+        Op op = Op::Truthy;
+        Expression left;
+        Expression right;
+    };
+
+    struct Node
+    {
+        enum class Kind
+        {
+            Text,
+            Output,
+            For,
+            If,
+            Include,
+            Cache
+        };
+
+        Kind kind = Kind::Text;
+        std::string_view text;
+
+        // Output value, For collection or Include "with" value.
+        Expression expr;
+        Condition condition;
+
+        std::string itemVar;
+        std::string indexVar;
+        std::string templateName;
+        bool hasWith = false;
+
+        // Cache key as literal pieces and interpolated values, and its lifetime
+        // in seconds.
+        std::vector<Expression> cacheKey;
+        int ttl = 60;
+
+        std::vector<Node> body;
+        std::vector<Node> elseBody;
+    };
+
+    // Template source parsed once into a node tree. Text nodes point into the
+    // owned source, so instances are neither copied nor moved. With a registry,
+    // filters are bound here and an unknown name throws std::runtime_error.
+    class CompiledTemplate
+    {
+    public:
+        explicit CompiledTemplate(std::string source, const FilterRegistry *filters = nullptr);
+
+        CompiledTemplate(const CompiledTemplate &) = delete;
+        CompiledTemplate &operator=(const CompiledTemplate &) = delete;
+
+        const std::string &source() const { return text; }
+        const std::vector<Node> &nodes() const { return root; }
+
+    private:
+        std::string text;
+        std::vector<Node> root;
+    };
+}
+
+#endif
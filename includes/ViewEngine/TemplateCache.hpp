@@ -0,0 +1,48 @@
+#ifndef NERVA_TEMPLATE_CACHE_HPP
+#define NERVA_TEMPLATE_CACHE_HPP
+
+#include "Template.hpp"
+
+#include <functional>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Nerva
+{
+    // Read-mostly map of compiled templates. Lookups take a shared lock on one
+    // shard; replacing an entry swaps the pointer, so renders already holding
+    // the old template finish with it.
+    class TemplateCache
+    {
+    public:
+        using Compiled = std::shared_ptr<const CompiledTemplate>;
+        using Loader = std::function<Compiled(const std::string &)>;
+
+        explicit TemplateCache(size_t shardCount = 16);
+
+        // Compiles through loader on a miss; concurrent misses may both compile,
+        // but only the first result is kept.
+        Compiled get(const std::string &name, const Loader &loader);
+
+        Compiled find(const std::string &name);
+        void put(const std::string &name, Compiled compiled);
+        void erase(const std::string &name);
+        void clear();
+
+    private:
+        struct Shard
+        {
+            std::shared_mutex mtx;
+            std::unordered_map<std::string, Compiled> entries;
+        };
+
+        std::vector<std::unique_ptr<Shard>> shards;
+
+        Shard &shardFor(const std::string &name);
+    };
+}
+
+#endif
@@ -0,0 +1,439 @@
+#ifndef NERVA_VALUE_HPP
+#define NERVA_VALUE_HPP
+
+#include <nlohmann/json.hpp>
+
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace Nerva
+{
+    using json = nlohmann::json;
+
+    class Value;
+
+    // How the engine reads one C++ type in place; built once per type by
+    // Value::of. Entries that do not apply to the kind are null.
+    struct TypeInfo
+    {
+        enum class Kind
+        {
+            Bool,
+            Integer,
+            Number,
+            String,
+            Array,
+            Object
+        };
+
+        using Visit = void (*)(void *state, const Value &key, const Value &value);
+
+        Kind kind;
+        bool (*boolean)(const void *) = nullptr;
+        long long (*integer)(const void *) = nullptr;
+        double (*number)(const void *) = nullptr;
+        std::string_view (*string)(const void *) = nullptr;
+        size_t (*size)(const void *) = nullptr;
+        Value (*at)(const void *, size_t) = nullptr;
+        Value (*member)(const void *, const std::string &) = nullptr;
+        void (*each)(const void *, Visit, void *) = nullptr;
+        json (*toJson)(const void *) = nullptr;
+    };
+
+    // Describes a struct's fields for templates; see NERVA_REFLECT below.
+    template <typename T>
+    struct Reflect;
+
+    template <typename Class, typename Member>
+    struct Field
+    {
+        std::string_view name;
+        Member Class::*pointer;
+    };
+
+    template <typename Class, typename Member>
+    constexpr Field<Class, Member> field(std::string_view name, Member Class::*pointer)
+    {
+        return {name, pointer};
+    }
+
+    // Read-only view of a template value: a json node or any C++ object the
+    // engine can describe (scalars, strings, containers, reflected structs).
+    // Holds pointers only, so what it refers to must outlive it.
+    class Value
+    {
+    public:
+        Value() = default;
+        Value(const json &node) : jsonNode(&node) {}
+
+        template <typename T>
+        static Value of(const T &object);
+
+        // Nothing was found; behaves like null.
+        bool missing() const { return !jsonNode && !type; }
+
+        // The json node behind this value, if it has one.
+        const json *node() const { return jsonNode; }
+
+        bool isNull() const { return missing() || (jsonNode && jsonNode->is_null()); }
+        bool isBool() const { return is(json::value_t::boolean, TypeInfo::Kind::Bool); }
+        bool isString() const { return is(json::value_t::string, TypeInfo::Kind::String); }
+        bool isArray() const { return is(json::value_t::array, TypeInfo::Kind::Array); }
+        bool isObject() const { return is(json::value_t::object, TypeInfo::Kind::Object); }
+        bool isNumber() const
+        {
+            return jsonNode ? jsonNode->is_number() : type && (type->kind == TypeInfo::Kind::Integer || type->kind == TypeInfo::Kind::Number);
+        }
+        bool isInteger() const
+        {
+            return jsonNode ? jsonNode->is_number_integer() : type && type->kind == TypeInfo::Kind::Integer;
+        }
+
+        bool boolean() const { return jsonNode ? jsonNode->get<bool>() : type->boolean(object); }
+        long long integer() const { return jsonNode ? jsonNode->get<long long>() : type->integer(object); }
+        double number() const { return jsonNode ? jsonNode->get<double>() : type->number(object); }
+        std::string_view string() const
+        {
+            return jsonNode ? std::string_view(jsonNode->get_ref<const std::string &>()) : type->string(object);
+        }
+
+        size_t size() const
+        {
+            if (jsonNode)
+                return jsonNode->is_array() || jsonNode->is_object() ? jsonNode->size() : 0;
+            return type && type->size ? type->size(object) : 0;
+        }
+
+        // Array element, or missing when out of range.
+        Value at(size_t index) const
+        {
+            if (jsonNode)
+                return jsonNode->is_array() && index < jsonNode->size() ? Value((*jsonNode)[index]) : Value();
+            return type && type->at && index < type->size(object) ? type->at(object, index) : Value();
+        }
+
+        // Object member, or missing.
+        Value member(const std::string &key) const
+        {
+            if (jsonNode)
+            {
+                if (!jsonNode->is_object())
+                    return {};
+                auto it = jsonNode->find(key);
+                return it == jsonNode->end() ? Value() : Value(*it);
+            }
+            return type && type->member ? type->member(object, key) : Value();
+        }
+
+        // Calls visit(key, value) for each member of an object, in order.
+        template <typename F>
+        void each(F &&visit) const
+        {
+            if (jsonNode)
+            {
+                if (!jsonNode->is_object())
+                    return;
+                for (auto it = jsonNode->begin(); it != jsonNode->end(); ++it)
+                    visit(Value::of(it.key()), Value(it.value()));
+            }
+            else if (type && type->each)
+            {
+                type->each(
+                    object, [](void *state, const Value &key, const Value &value)
+                    { (*static_cast<std::remove_reference_t<F> *>(state))(key, value); },
+                    const_cast<void *>(static_cast<const void *>(std::addressof(visit))));
+            }
+        }
+
+        // The node itself for json values; otherwise a copy built in scratch.
+        const json &asJson(json &scratch) const
+        {
+            if (jsonNode)
+                return *jsonNode;
+            scratch = type ? type->toJson(object) : json();
+            return scratch;
+        }
+
+    private:
+        const json *jsonNode = nullptr;
+        const void *object = nullptr;
+        const TypeInfo *type = nullptr;
+
+        Value(const void *object, const TypeInfo *type) : object(object), type(type) {}
+
+        bool is(json::value_t jsonType, TypeInfo::Kind kind) const
+        {
+            return jsonNode ? jsonNode->type() == jsonType : type && type->kind == kind;
+        }
+    };
+
+    namespace Detail
+    {
+        template <typename T, typename = void>
+        struct IsReflected : std::false_type
+        {
+        };
+
+        template <typename T>
+        struct IsReflected<T, std::void_t<decltype(Reflect<T>::fields)>> : std::true_type
+        {
+        };
+
+        template <typename T, typename = void>
+        struct IsRange : std::false_type
+        {
+        };
+
+        template <typename T>
+        struct IsRange<T, std::void_t<decltype(std::begin(std::declval<const T &>())), decltype(std::end(std::declval<const T &>()))>> : std::true_type
+        {
+        };
+
+        template <typename T, typename = void>
+        struct IsMap : std::false_type
+        {
+        };
+
+        template <typename T>
+        struct IsMap<T, std::void_t<typename T::key_type, typename T::mapped_type>> : std::true_type
+        {
+        };
+
+        template <typename T>
+        struct IsOptional : std::false_type
+        {
+        };
+
+        template <typename T>
+        struct IsOptional<std::optional<T>> : std::true_type
+        {
+        };
+
+        template <typename T>
+        struct IsPointer : std::is_pointer<T>
+        {
+        };
+
+        template <typename T>
+        struct IsPointer<std::shared_ptr<T>> : std::true_type
+        {
+        };
+
+        template <typename T, typename D>
+        struct IsPointer<std::unique_ptr<T, D>> : std::true_type
+        {
+        };
+
+        template <typename T>
+        constexpr bool IsString = std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view> || std::is_same_v<T, const char *>;
+
+        inline const json &null()
+        {
+            static const json value;
+            return value;
+        }
+    }
+
+    template <typename T>
+    struct Describe
+    {
+        static_assert(!std::is_same_v<T, T>, "Nerva::Value: type is not a scalar, string, container or NERVA_REFLECT struct");
+    };
+
+    template <typename T>
+    Value Value::of(const T &object)
+    {
+        if constexpr (std::is_same_v<T, json>)
+            return Value(object);
+        else if constexpr (Detail::IsOptional<T>::value)
+            return object ? Value::of(*object) : Value(Detail::null());
+        else if constexpr (Detail::IsPointer<T>::value && !Detail::IsString<T>)
+            return object ? Value::of(*object) : Value(Detail::null());
+        else
+            return Value(std::addressof(object), &Describe<T>::info);
+    }
+
+    template <>
+    struct Describe<bool>
+    {
+        static constexpr TypeInfo info{
+            .kind = TypeInfo::Kind::Bool,
+            .boolean = [](const void *p)
+            { return *static_cast<const bool *>(p); },
+            .toJson = [](const void *p)
+            { return json(*static_cast<const bool *>(p)); }};
+    };
+
+    template <typename T>
+        requires(std::is_integral_v<T> && !std::is_same_v<T, bool>)
+    struct Describe<T>
+    {
+        static constexpr TypeInfo info{
+            .kind = TypeInfo::Kind::Integer,
+            .integer = [](const void *p)
+            { return static_cast<long long>(*static_cast<const T *>(p)); },
+            .number = [](const void *p)
+            { return static_cast<double>(*static_cast<const T *>(p)); },
+            .toJson = [](const void *p)
+            { return json(*static_cast<const T *>(p)); }};
+    };
+
+    template <typename T>
+        requires std::is_floating_point_v<T>
+    struct Describe<T>
+    {
+        static constexpr TypeInfo info{
+            .kind = TypeInfo::Kind::Number,
+            .number = [](const void *p)
+            { return static_cast<double>(*static_cast<const T *>(p)); },
+            .toJson = [](const void *p)
+            { return json(*static_cast<const T *>(p)); }};
+    };
+
+    template <typename T>
+        requires Detail::IsString<T>
+    struct Describe<T>
+    {
+        static constexpr TypeInfo info{
+            .kind = TypeInfo::Kind::String,
+            .string = [](const void *p)
+            { return std::string_view(*static_cast<const T *>(p)); },
+            .toJson = [](const void *p)
+            { return json(std::string(std::string_view(*static_cast<const T *>(p)))); }};
+    };
+
+    template <typename T>
+        requires(Detail::IsMap<T>::value && !Detail::IsString<T>)
+    struct Describe<T>
+    {
+        static constexpr TypeInfo info{
+            .kind = TypeInfo::Kind::Object,
+            .size = [](const void *p)
+            { return static_cast<const T *>(p)->size(); },
+            .member = [](const void *p, const std::string &key)
+            {
+                const T &map = *static_cast<const T *>(p);
+                auto it = map.find(key);
+                return it == map.end() ? Value() : Value::of(it->second);
+            },
+            .each = [](const void *p, TypeInfo::Visit visit, void *state)
+            {
+                for (const auto &[key, value] : *static_cast<const T *>(p))
+                    visit(state, Value::of(key), Value::of(value));
+            },
+            .toJson = [](const void *p)
+            {
+                json out = json::object();
+                for (const auto &[key, value] : *static_cast<const T *>(p))
+                {
+                    json scratch;
+                    out[std::string(key)] = Value::of(value).asJson(scratch);
+                }
+                return out;
+            }};
+    };
+
+    template <typename T>
+        requires(Detail::IsRange<T>::value && !Detail::IsMap<T>::value && !Detail::IsString<T> && !std::is_same_v<T, json>)
+    struct Describe<T>
+    {
+        static constexpr TypeInfo info{
+            .kind = TypeInfo::Kind::Array,
+            .size = [](const void *p)
+            { return static_cast<size_t>(std::distance(std::begin(*static_cast<const T *>(p)), std::end(*static_cast<const T *>(p)))); },
+            .at = [](const void *p, size_t index)
+            { return Value::of(*std::next(std::begin(*static_cast<const T *>(p)), index)); },
+            .toJson = [](const void *p)
+            {
+                json out = json::array();
+                for (const auto &item : *static_cast<const T *>(p))
+                {
+                    json scratch;
+                    out.push_back(Value::of(item).asJson(scratch));
+                }
+                return out;
+            }};
+    };
+
+    template <typename T>
+        requires Detail::IsReflected<T>::value
+    struct Describe<T>
+    {
+        static constexpr size_t Count = std::tuple_size_v<std::decay_t<decltype(Reflect<T>::fields)>>;
+
+        template <size_t... I>
+        static Value member(const T &object, const std::string &key, std::index_sequence<I...>)
+        {
+            Value found;
+            ((std::get<I>(Reflect<T>::fields).name == key ? (found = Value::of(object.*std::get<I>(Reflect<T>::fields).pointer), true) : false) || ...);
+            return found;
+        }
+
+        template <size_t... I>
+        static void each(const T &object, TypeInfo::Visit visit, void *state, std::index_sequence<I...>)
+        {
+            (visit(state, Value::of(std::get<I>(Reflect<T>::fields).name), Value::of(object.*std::get<I>(Reflect<T>::fields).pointer)), ...);
+        }
+
+        static constexpr TypeInfo info{
+            .kind = TypeInfo::Kind::Object,
+            .size = [](const void *)
+            { return Count; },
+            .member = [](const void *p, const std::string &key)
+            { return member(*static_cast<const T *>(p), key, std::make_index_sequence<Count>()); },
+            .each = [](const void *p, TypeInfo::Visit visit, void *state)
+            { each(*static_cast<const T *>(p), visit, state, std::make_index_sequence<Count>()); },
+            .toJson = [](const void *p)
+            {
+                json out = json::object();
+                each(*static_cast<const T *>(p), [](void *state, const Value &key, const Value &value)
+                     {
+                         json scratch;
+                         (*static_cast<json *>(state))[std::string(key.string())] = value.asJson(scratch); },
+                     &out, std::make_index_sequence<Count>());
+                return out;
+            }};
+    };
+}
+
+#define NERVA_REFLECT_FIELD(Type, name) ::Nerva::field(#name, &Type::name)
+#define NERVA_REFLECT_1(T, a) NERVA_REFLECT_FIELD(T, a)
+#define NERVA_REFLECT_2(T, a, ...) NERVA_REFLECT_FIELD(T, a), NERVA_REFLECT_1(T, __VA_ARGS__)
+#define NERVA_REFLECT_3(T, a, ...) NERVA_REFLECT_FIELD(T, a), NERVA_REFLECT_2(T, __VA_ARGS__)
+#define NERVA_REFLECT_4(T, a, ...) NERVA_REFLECT_FIELD(T, a), NERVA_REFLECT_3(T, __VA_ARGS__)
+#define NERVA_REFLECT_5(T, a, ...) NERVA_REFLECT_FIELD(T, a), NERVA_REFLECT_4(T, __VA_ARGS__)
+#define NERVA_REFLECT_6(T, a, ...) NERVA_REFLECT_FIELD(T, a), NERVA_REFLECT_5(T, __VA_ARGS__)
+#define NERVA_REFLECT_7(T, a, ...) NERVA_REFLECT_FIELD(T, a), NERVA_REFLECT_6(T, __VA_ARGS__)
+#define NERVA_REFLECT_8(T, a, ...) NERVA_REFLECT_FIELD(T, a), NERVA_REFLECT_7(T, __VA_ARGS__)
+#define NERVA_REFLECT_9(T, a, ...) NERVA_REFLECT_FIELD(T, a), NERVA_REFLECT_8(T, __VA_ARGS__)
+#define NERVA_REFLECT_10(T, a, ...) NERVA_REFLECT_FIELD(T, a), NERVA_REFLECT_9(T, __VA_ARGS__)
+#define NERVA_REFLECT_11(T, a, ...) NERVA_REFLECT_FIELD(T, a), NERVA_REFLECT_10(T, __VA_ARGS__)
+#define NERVA_REFLECT_12(T, a, ...) NERVA_REFLECT_FIELD(T, a), NERVA_REFLECT_11(T, __VA_ARGS__)
+#define NERVA_REFLECT_13(T, a, ...) NERVA_REFLECT_FIELD(T, a), NERVA_REFLECT_12(T, __VA_ARGS__)
+#define NERVA_REFLECT_14(T, a, ...) NERVA_REFLECT_FIELD(T, a), NERVA_REFLECT_13(T, __VA_ARGS__)
+#define NERVA_REFLECT_15(T, a, ...) NERVA_REFLECT_FIELD(T, a), NERVA_REFLECT_14(T, __VA_ARGS__)
+#define NERVA_REFLECT_16(T, a, ...) NERVA_REFLECT_FIELD(T, a), NERVA_REFLECT_15(T, __VA_ARGS__)
+#define NERVA_REFLECT_PICK(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, N, ...) N
+
+// NERVA_REFLECT(Product, id, name, price) lets templates read those members of
+// a Product in place: {{ product.name }}. Use at global scope; up to 16 fields.
+#define NERVA_REFLECT(Type, ...)                                                                          \
+    template <>                                                                                           \
+    struct Nerva::Reflect<Type>                                                                           \
+    {                                                                                                     \
+        static constexpr auto fields = std::make_tuple(                                                   \
+            NERVA_REFLECT_PICK(__VA_ARGS__, NERVA_REFLECT_16, NERVA_REFLECT_15, NERVA_REFLECT_14,         \
+                               NERVA_REFLECT_13, NERVA_REFLECT_12, NERVA_REFLECT_11, NERVA_REFLECT_10,    \
+                               NERVA_REFLECT_9, NERVA_REFLECT_8, NERVA_REFLECT_7, NERVA_REFLECT_6,        \
+                               NERVA_REFLECT_5, NERVA_REFLECT_4, NERVA_REFLECT_3, NERVA_REFLECT_2,        \
+                               NERVA_REFLECT_1)(Type, __VA_ARGS__));                                      \
+    };
+
+#endif
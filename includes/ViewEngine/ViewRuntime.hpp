@@ -0,0 +1,51 @@
+#ifndef NERVA_VIEW_RUNTIME_HPP
+#define NERVA_VIEW_RUNTIME_HPP
+
+#include "Engine.hpp"
+
+#include <initializer_list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Shared by the interpreter and by views compiled to C++ with `make views`
+// (tools/ViewCompiler.cpp), so both print, compare and look up values alike.
+namespace Nerva::View
+{
+    using Scope = Engine::Scope;
+    using Output = Engine::Output;
+
+    // filters holds one function per name in the generated file's filter list,
+    // bound by the engine that renders it; null entries pass values through.
+    using Render = void (*)(Engine &engine, const Scope &scope, Output &out, const FilterFunction *filters);
+
+    struct Compiled
+    {
+        const char *name;
+        Render render;
+    };
+
+    struct Registry
+    {
+        std::vector<std::string> filters;
+        std::unordered_map<std::string, Render> views;
+    };
+
+    // Called once from the generated file's static initializer.
+    bool Register(std::vector<std::string> filters, std::initializer_list<Compiled> views);
+
+    // nullptr unless compiled views are linked in.
+    const Registry *Registered();
+
+    void write(const Value &value, bool raw, Http::OutputBuffer &out);
+    bool truthy(const Value &value);
+    bool compare(Condition::Op op, const Value &left, const Value &right);
+
+    // Same as toText(), without converting typed values to json first.
+    std::string text(const Value &value);
+
+    // value[index] for arrays and strings; a string's character lands in storage.
+    Value element(const Value &value, size_t index, json &storage);
+}
+
+#endif
@@ -0,0 +1,38 @@
+#include "AsyncHandler.hpp"
+#include "Completion.hpp"
+
+#include <memory>
+
+namespace Nerva
+{
+    namespace
+    {
+        Detached drive(Task<void> task, std::shared_ptr<Completion> completion)
+        {
+            std::exception_ptr error;
+            try
+            {
+                // Destroy the handler frame before finishing, since finishing
+                // may release the request and response it refers to.
+                Task<void> handler = std::move(task);
+                co_await handler;
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+            completion->finish(error);
+        }
+    }
+
+    RequestHandler Async(AsyncHandler handler)
+    {
+        return [handler = std::move(handler)](const Http::Request &req, Http::Response &res, NextFunction)
+        {
+            auto completion = std::make_shared<Completion>();
+            res.pending = completion;
+            // The server owns the request for the lifetime of the task.
+            drive(handler(const_cast<Http::Request &>(req), res), std::move(completion));
+        };
+    }
+}
@@ -0,0 +1,48 @@
+#include "Completion.hpp"
+
+namespace Nerva
+{
+    void Completion::finish(std::exception_ptr failure)
+    {
+        std::function<void()> pending;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            done = true;
+            error = failure;
+            pending = std::move(callback);
+        }
+        cv.notify_all();
+
+        if (pending)
+            pending();
+    }
+
+    bool Completion::then(std::function<void()> next)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (done)
+            return false;
+        callback = std::move(next);
+        return true;
+    }
+
+    void Completion::wait()
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        cv.wait(lock, [this]
+                { return done; });
+    }
+
+    bool Completion::finished()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return done;
+    }
+
+    void Completion::rethrow()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (error)
+            std::rethrow_exception(error);
+    }
+}
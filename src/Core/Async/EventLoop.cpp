@@ -0,0 +1,218 @@
+#include "EventLoop.hpp"
+
+#include <cstdio>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+namespace Nerva
+{
+    namespace
+    {
+        thread_local bool insideLoop = false;
+    }
+
+    EventLoop &EventLoop::Instance()
+    {
+        static EventLoop loop;
+        return loop;
+    }
+
+    bool EventLoop::InLoop()
+    {
+        return insideLoop;
+    }
+
+    EventLoop::~EventLoop()
+    {
+        Stop();
+    }
+
+    void EventLoop::Stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (!running)
+                return;
+            running = false;
+        }
+
+        wake();
+        if (thread.joinable())
+            thread.join();
+
+        close(wakeFd);
+        close(epollFd);
+        wakeFd = epollFd = -1;
+    }
+
+    void EventLoop::post(std::function<void()> task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            ensureRunning();
+            tasks.push_back(std::move(task));
+        }
+        wake();
+    }
+
+    void EventLoop::resumeAt(Clock::time_point when, std::coroutine_handle<> handle)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            ensureRunning();
+            timers.push({when, handle, -1, 0});
+        }
+        wake();
+    }
+
+    void EventLoop::resumeWhenReady(int fd, uint32_t events, std::coroutine_handle<> handle, Clock::time_point deadline)
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        ensureRunning();
+        uint64_t id = ++nextWatch;
+        watches[fd] = {handle, id};
+
+        struct epoll_event event;
+        event.events = events | EPOLLONESHOT;
+        event.data.fd = fd;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) == 0 ||
+            (errno == EEXIST && epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &event) == 0))
+        {
+            if (deadline == Clock::time_point::max())
+                return;
+
+            // The loop may be sleeping past the deadline.
+            timers.push({deadline, handle, fd, id});
+            lock.unlock();
+            wake();
+            return;
+        }
+
+        // Regular files cannot be polled and are always ready.
+        watches.erase(fd);
+        tasks.push_back([handle]
+                        { handle.resume(); });
+        lock.unlock();
+        wake();
+    }
+
+    void EventLoop::ensureRunning()
+    {
+        if (running)
+            return;
+
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (epollFd == -1 || wakeFd == -1)
+        {
+            perror("event loop");
+            return;
+        }
+
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.fd = wakeFd;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event);
+
+        running = true;
+        thread = std::thread(&EventLoop::run, this);
+    }
+
+    void EventLoop::wake()
+    {
+        uint64_t one = 1;
+        if (write(wakeFd, &one, sizeof(one)) < 0 && errno != EAGAIN)
+            perror("eventfd write");
+    }
+
+    int EventLoop::nextTimeout()
+    {
+        if (!tasks.empty())
+            return 0;
+        if (timers.empty())
+            return -1;
+
+        auto wait = std::chrono::ceil<std::chrono::milliseconds>(timers.top().when - Clock::now());
+        return wait.count() > 0 ? static_cast<int>(wait.count()) : 0;
+    }
+
+    void EventLoop::run()
+    {
+        insideLoop = true;
+        struct epoll_event events[64];
+        std::vector<std::function<void()>> ready;
+        std::vector<std::coroutine_handle<>> resumable;
+
+        while (true)
+        {
+            int timeout;
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                if (!running)
+                    break;
+                timeout = nextTimeout();
+            }
+
+            int numEvents = epoll_wait(epollFd, events, 64, timeout);
+            if (numEvents == -1 && errno != EINTR)
+            {
+                perror("epoll_wait");
+                break;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+
+                for (int i = 0; i < numEvents; ++i)
+                {
+                    int fd = events[i].data.fd;
+                    if (fd == wakeFd)
+                    {
+                        uint64_t count;
+                        while (read(wakeFd, &count, sizeof(count)) > 0)
+                        {
+                        }
+                        continue;
+                    }
+
+                    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+                    auto it = watches.find(fd);
+                    if (it != watches.end())
+                    {
+                        resumable.push_back(it->second.handle);
+                        watches.erase(it);
+                    }
+                }
+
+                auto now = Clock::now();
+                while (!timers.empty() && timers.top().when <= now)
+                {
+                    Timer timer = timers.top();
+                    timers.pop();
+
+                    if (timer.fd != -1)
+                    {
+                        // The watch already fired, or was replaced by a later one.
+                        auto it = watches.find(timer.fd);
+                        if (it == watches.end() || it->second.id != timer.watch)
+                            continue;
+                        epoll_ctl(epollFd, EPOLL_CTL_DEL, timer.fd, nullptr);
+                        watches.erase(it);
+                    }
+                    resumable.push_back(timer.handle);
+                }
+
+                ready.swap(tasks);
+            }
+
+            for (auto handle : resumable)
+                handle.resume();
+            for (auto &task : ready)
+                task();
+
+            resumable.clear();
+            ready.clear();
+        }
+    }
+}
@@ -0,0 +1,123 @@
+#include "OffloadPool.hpp"
+#include "EventLoop.hpp"
+
+namespace Nerva
+{
+    OffloadPool &OffloadPool::Shared()
+    {
+        static OffloadPool pool;
+        return pool;
+    }
+
+    OffloadPool::~OffloadPool()
+    {
+        Stop();
+    }
+
+    void OffloadPool::configure(size_t threads, size_t limit)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        threadCount = threads ? threads : 1;
+        queueLimit = limit;
+    }
+
+    bool OffloadPool::submit(std::function<void()> job, std::function<void(std::exception_ptr)> done)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (stopping || queue.size() >= queueLimit)
+            {
+                rejected++;
+                return false;
+            }
+
+            if (!started)
+            {
+                started = true;
+                for (size_t i = 0; i < threadCount; ++i)
+                {
+                    workers.emplace_back(&OffloadPool::work, this);
+                }
+            }
+
+            queue.push_back({std::move(job), std::move(done), Clock::now()});
+            submitted++;
+        }
+        cv.notify_one();
+        return true;
+    }
+
+    OffloadPool::Stats OffloadPool::stats()
+    {
+        Stats snapshot;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            snapshot.queued = queue.size();
+        }
+        snapshot.submitted = submitted;
+        snapshot.rejected = rejected;
+        snapshot.completed = completed;
+        snapshot.failed = failed;
+        snapshot.active = active;
+        snapshot.queueWait = std::chrono::nanoseconds(queueWaitNs.load());
+        snapshot.runTime = std::chrono::nanoseconds(runTimeNs.load());
+        return snapshot;
+    }
+
+    void OffloadPool::Stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stopping = true;
+        }
+        cv.notify_all();
+
+        for (auto &t : workers)
+        {
+            if (t.joinable())
+                t.join();
+        }
+        workers.clear();
+    }
+
+    void OffloadPool::work()
+    {
+        while (true)
+        {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                cv.wait(lock, [this]
+                        { return stopping || !queue.empty(); });
+                if (queue.empty())
+                    return;
+                job = std::move(queue.front());
+                queue.pop_front();
+            }
+
+            auto start = Clock::now();
+            queueWaitNs += std::chrono::duration_cast<std::chrono::nanoseconds>(start - job.queuedAt).count();
+            active++;
+
+            std::exception_ptr error;
+            try
+            {
+                job.run();
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+
+            active--;
+            runTimeNs += std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+            (error ? failed : completed)++;
+
+            if (job.done)
+            {
+                EventLoop::Instance().post([done = std::move(job.done), error]()
+                                           { done(error); });
+            }
+        }
+    }
+}
@@ -0,0 +1,49 @@
+#include "RequestKey.hpp"
+
+#include <algorithm>
+
+std::string Http::RequestKey(const Request &req, const Response &res, const std::vector<std::string> &vary)
+{
+    std::string key = req.method;
+    key += ' ';
+    key += req.path;
+
+    if (!req.query.empty())
+    {
+        std::vector<std::pair<std::string, std::string>> query(req.query.begin(), req.query.end());
+        std::sort(query.begin(), query.end());
+
+        char separator = '?';
+        for (const auto &[name, value] : query)
+        {
+            key += separator;
+            key += name;
+            key += '=';
+            key += value;
+            separator = '&';
+        }
+    }
+
+    for (const auto &entry : vary)
+    {
+        size_t colon = entry.find(':');
+        std::string source = colon == std::string::npos ? "Header" : entry.substr(0, colon);
+        std::string name = colon == std::string::npos ? entry : entry.substr(colon + 1);
+
+        key += '\n';
+        if (source == "Cookie")
+        {
+            key += res.getCookieValue(name);
+        }
+        else if (source == "Query")
+        {
+            key += req.getQuery(name);
+        }
+        else
+        {
+            key += req.getHeader(name);
+        }
+    }
+
+    return key;
+}
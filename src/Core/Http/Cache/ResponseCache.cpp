@@ -0,0 +1,126 @@
+#include "ResponseCache.hpp"
+
+#include <functional>
+
+namespace Http
+{
+    ResponseCache::ResponseCache(size_t capacityBytes, size_t shardCount)
+        : shardCapacity(capacityBytes / (shardCount ? shardCount : 1))
+    {
+        if (shardCount == 0)
+            shardCount = 1;
+
+        for (size_t i = 0; i < shardCount; ++i)
+        {
+            shards.push_back(std::make_unique<Shard>());
+        }
+    }
+
+    ResponseCache &ResponseCache::Shared()
+    {
+        static ResponseCache cache;
+        return cache;
+    }
+
+    void ResponseCache::setCapacity(size_t capacityBytes)
+    {
+        shardCapacity = capacityBytes / shards.size();
+
+        for (auto &shard : shards)
+        {
+            std::lock_guard<std::mutex> lock(shard->mtx);
+            while (shard->bytes > shardCapacity && !shard->lru.empty())
+            {
+                erase(*shard, std::prev(shard->lru.end()));
+            }
+        }
+    }
+
+    ResponseCache::Bytes ResponseCache::lookup(const std::string &key, Clock::time_point now)
+    {
+        Shard &shard = shardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mtx);
+
+        auto it = shard.index.find(key);
+        if (it == shard.index.end())
+            return nullptr;
+
+        auto entryIt = it->second;
+        Entry &entry = entryIt->second;
+
+        if (now < entry.freshUntil)
+        {
+            shard.lru.splice(shard.lru.begin(), shard.lru, entryIt);
+            return entry.bytes;
+        }
+
+        if (now < entry.staleUntil)
+        {
+            if (!entry.revalidating)
+            {
+                entry.revalidating = true;
+                return nullptr;
+            }
+            return entry.bytes;
+        }
+
+        erase(shard, entryIt);
+        return nullptr;
+    }
+
+    void ResponseCache::store(const std::string &key, Bytes bytes, Clock::time_point freshUntil, Clock::time_point staleUntil)
+    {
+        Shard &shard = shardFor(key);
+        Entry entry{std::move(bytes), freshUntil, staleUntil, false};
+        size_t size = charge(key, entry);
+
+        std::lock_guard<std::mutex> lock(shard.mtx);
+
+        auto it = shard.index.find(key);
+        if (it != shard.index.end())
+        {
+            erase(shard, it->second);
+        }
+
+        if (size > shardCapacity)
+            return;
+
+        while (shard.bytes + size > shardCapacity && !shard.lru.empty())
+        {
+            erase(shard, std::prev(shard.lru.end()));
+        }
+
+        shard.lru.emplace_front(key, std::move(entry));
+        shard.index[key] = shard.lru.begin();
+        shard.bytes += size;
+    }
+
+    void ResponseCache::release(const std::string &key)
+    {
+        Shard &shard = shardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mtx);
+
+        auto it = shard.index.find(key);
+        if (it != shard.index.end())
+        {
+            it->second->second.revalidating = false;
+        }
+    }
+
+    ResponseCache::Shard &ResponseCache::shardFor(const std::string &key)
+    {
+        return *shards[std::hash<std::string>{}(key) % shards.size()];
+    }
+
+    size_t ResponseCache::charge(const std::string &key, const Entry &entry)
+    {
+        return key.size() * 2 + (entry.bytes ? entry.bytes->size() : 0) + sizeof(Entry) + 64;
+    }
+
+    void ResponseCache::erase(Shard &shard, std::list<std::pair<std::string, Entry>>::iterator it)
+    {
+        shard.bytes -= charge(it->first, it->second);
+        shard.index.erase(it->first);
+        shard.lru.erase(it);
+    }
+}
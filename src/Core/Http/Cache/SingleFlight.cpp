@@ -0,0 +1,60 @@
+#include "SingleFlight.hpp"
+
+namespace Http
+{
+    SingleFlight::SingleFlight(CoalesceOptions options) : options(std::move(options)) {}
+
+    std::shared_ptr<SingleFlight::Call> SingleFlight::join(const std::string &key, bool &leader)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = calls.find(key);
+        if (it != calls.end())
+        {
+            leader = false;
+            return it->second;
+        }
+
+        auto call = std::make_shared<Call>();
+        calls.emplace(key, call);
+        leader = true;
+        return call;
+    }
+
+    bool SingleFlight::await(Call &call, Response &res, bool &handled)
+    {
+        std::unique_lock<std::mutex> lock(call.mtx);
+        if (!call.cv.wait_for(lock, options.maxWait, [&]
+                              { return call.done; }) ||
+            !call.response)
+        {
+            return false;
+        }
+
+        const Response &shared = *call.response;
+        res.statusCode = shared.statusCode;
+        res.statusMessage = shared.statusMessage;
+        res.headers = shared.headers;
+        res.body = shared.body;
+        res.output = shared.output;
+        res.serialized = shared.serialized;
+        handled = call.handled;
+        return true;
+    }
+
+    void SingleFlight::finish(const std::string &key, Call &call, bool handled, const Response *response)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            calls.erase(key);
+        }
+
+        std::lock_guard<std::mutex> lock(call.mtx);
+        call.done = true;
+        call.handled = handled;
+        if (response)
+        {
+            call.response = std::make_unique<const Response>(*response);
+        }
+        call.cv.notify_all();
+    }
+}
@@ -0,0 +1,36 @@
+#include "AssetManifest.hpp"
+
+namespace Http
+{
+    AssetManifest &AssetManifest::Shared()
+    {
+        static AssetManifest instance;
+        return instance;
+    }
+
+    void AssetManifest::add(const std::string &path, std::string url)
+    {
+        urls.emplace(path, std::move(url));
+    }
+
+    void AssetManifest::setFallbackPrefix(const std::string &prefix)
+    {
+        if (fallbackPrefix.empty())
+            fallbackPrefix = prefix;
+    }
+
+    std::string AssetManifest::url(std::string_view path) const
+    {
+        while (!path.empty() && path.front() == '/')
+            path.remove_prefix(1);
+
+        auto it = urls.find(std::string(path));
+        if (it != urls.end())
+            return it->second;
+
+        std::string fallback = fallbackPrefix;
+        if (fallback.empty() || fallback.back() != '/')
+            fallback += '/';
+        return fallback.append(path);
+    }
+}
@@ -1,8 +1,51 @@
 #include "StaticFileHandler.hpp"
+#include "AssetManifest.hpp"
 
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <filesystem>
+#include <cstdio>
+
+namespace
+{
+    bool unchanged(const struct stat &info, off_t size, const struct timespec &modified)
+    {
+        return info.st_size == size && info.st_mtim.tv_sec == modified.tv_sec && info.st_mtim.tv_nsec == modified.tv_nsec;
+    }
+
+    // FNV-1a over the file's bytes.
+    bool hashFile(const std::string &path, uint64_t &hash)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open())
+            return false;
+
+        hash = 14695981039346656037ull;
+        char buffer[64 * 1024];
+        while (file.read(buffer, sizeof(buffer)) || file.gcount() > 0)
+        {
+            for (std::streamsize i = 0; i < file.gcount(); ++i)
+            {
+                hash ^= static_cast<unsigned char>(buffer[i]);
+                hash *= 1099511628211ull;
+            }
+        }
+        return true;
+    }
+
+    // "css/app.css" -> "css/app.3f9a1c2e.css"
+    std::string fingerprintedName(const std::string &path, const char *hash)
+    {
+        size_t slash = path.find_last_of('/');
+        size_t dot = path.find_last_of('.');
+        size_t nameStart = slash == std::string::npos ? 0 : slash + 1;
+
+        if (dot == std::string::npos || dot <= nameStart)
+            return path + "." + hash;
+        return path.substr(0, dot) + "." + hash + path.substr(dot);
+    }
+}
 
 StaticFileHandler::StaticFileHandler(const std::string &basePath) : basePath(basePath)
 {
@@ -24,7 +67,7 @@ StaticFileHandler::StaticFileHandler(const std::string &basePath) : basePath(bas
     mimeTypes[".mp4"] = "video/mp4";
 }
 
-void StaticFileHandler::Handle(Http::Request &req, Http::Response &res, std::function<void()> next)
+void StaticFileHandler::Handle(Http::Request &req, Http::Response &res, Next next)
 {
     if (req.method != "GET" && req.method != "HEAD")
     {
@@ -32,11 +75,37 @@ void StaticFileHandler::Handle(Http::Request &req, Http::Response &res, std::fun
         return;
     }
 
-    std::string filePath = resolvePath(req.path);
+    std::string filePath = resolvePath(req.relativePath());
 
-    if (!fileExists(filePath))
+    struct stat info;
+    if (stat(filePath.c_str(), &info) != 0 || !S_ISREG(info.st_mode))
     {
-        next();
+        auto asset = fingerprinted.find(filePath);
+        if (asset == fingerprinted.end() || stat(asset->second.filePath.c_str(), &info) != 0 || !S_ISREG(info.st_mode))
+        {
+            next();
+            return;
+        }
+
+        // A file edited since startup no longer matches its hash, so it is
+        // served without the long-lived caching headers.
+        filePath = asset->second.filePath;
+        if (unchanged(info, asset->second.size, asset->second.modified))
+            res.headers["Cache-Control"] = "public, max-age=31536000, immutable";
+    }
+
+    auto cached = preloaded.find(filePath);
+    if (cached != preloaded.end() && unchanged(info, cached->second.size, cached->second.modified))
+    {
+        const Preloaded &file = cached->second;
+        res.headers["Content-Type"] = file.mimeType;
+        res.headers["Content-Length"] = std::to_string(file.content->size());
+        res << 200;
+        if (req.method == "GET")
+        {
+            res.output.retain(file.content);
+            res.output.reference(*file.content);
+        }
         return;
     }
 
@@ -55,7 +124,7 @@ void StaticFileHandler::Handle(Http::Request &req, Http::Response &res, std::fun
 
     if (req.method == "GET")
     {
-        res << 200 << content;
+        res << 200 << std::move(content);
     }
     else
     {
@@ -79,6 +148,43 @@ std::string StaticFileHandler::getMimeType(const std::string &path)
     return "application/octet-stream";
 }
 
+size_t StaticFileHandler::Fingerprint(const std::string &mountPath)
+{
+    Http::AssetManifest &manifest = Http::AssetManifest::Shared();
+    manifest.setFallbackPrefix(mountPath);
+
+    std::string prefix = mountPath;
+    if (prefix.empty() || prefix.back() != '/')
+        prefix += '/';
+
+    size_t count = 0;
+    std::error_code ec;
+
+    for (auto it = std::filesystem::recursive_directory_iterator(basePath, ec); !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec))
+    {
+        std::string relative = std::filesystem::relative(it->path(), basePath, ec).generic_string();
+        std::string filePath = resolvePath(relative);
+
+        struct stat info;
+        uint64_t hash;
+        if (ec || stat(filePath.c_str(), &info) != 0 || !S_ISREG(info.st_mode) || !hashFile(filePath, hash))
+        {
+            ec.clear();
+            continue;
+        }
+
+        char digits[9];
+        snprintf(digits, sizeof(digits), "%08x", static_cast<unsigned>(hash ^ (hash >> 32)));
+
+        std::string hashed = fingerprintedName(relative, digits);
+        fingerprinted[resolvePath(hashed)] = Fingerprinted{filePath, info.st_size, info.st_mtim};
+        manifest.add(relative, prefix + hashed);
+        ++count;
+    }
+
+    return count;
+}
+
 bool StaticFileHandler::SendFile(const std::string& filePath, Http::Response& res)
 {
     struct stat buffer;
@@ -103,18 +209,47 @@ bool StaticFileHandler::SendFile(const std::string& filePath, Http::Response& re
 
     res.headers["Content-Type"] = mimeType;
     res.headers["Content-Length"] = std::to_string(content.size());
-    res << 200 << content;
+    res << 200 << std::move(content);
 
     return true;
 }
 
-bool StaticFileHandler::fileExists(const std::string &path)
+size_t StaticFileHandler::Preload(size_t maxBytes)
 {
-    struct stat buffer;
-    return (stat(path.c_str(), &buffer) == 0 && S_ISREG(buffer.st_mode));
+    size_t loaded = 0;
+    std::error_code ec;
+
+    for (auto it = std::filesystem::recursive_directory_iterator(basePath, ec); !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec))
+    {
+        std::string relative = std::filesystem::relative(it->path(), basePath, ec).generic_string();
+        std::string filePath = resolvePath(relative);
+
+        struct stat info;
+        if (ec || stat(filePath.c_str(), &info) != 0 || !S_ISREG(info.st_mode))
+        {
+            ec.clear();
+            continue;
+        }
+        if (static_cast<size_t>(info.st_size) > maxBytes - loaded)
+            continue;
+
+        std::ifstream file(filePath, std::ios::binary);
+        if (!file.is_open())
+            continue;
+
+        auto content = std::make_shared<const std::string>((std::istreambuf_iterator<char>(file)),
+                                                           std::istreambuf_iterator<char>());
+        if (content->size() != static_cast<size_t>(info.st_size))
+            continue;
+
+        loaded += content->size();
+        preloaded[filePath] = Preloaded{content, getMimeType(filePath), info.st_size, info.st_mtim};
+    }
+
+    return loaded;
 }
 
-std::string StaticFileHandler::resolvePath(const std::string &requestPath)
+std::string StaticFileHandler::resolvePath(std::string_view requestPath)
 {
     std::string result = basePath;
 
@@ -123,7 +258,7 @@ std::string StaticFileHandler::resolvePath(const std::string &requestPath)
         result += '/';
     }
 
-    std::string cleanRequestPath = (requestPath.front() == '/') ? requestPath.substr(1) : requestPath;
+    std::string_view cleanRequestPath = (requestPath.front() == '/') ? requestPath.substr(1) : requestPath;
 
     result += cleanRequestPath;
 
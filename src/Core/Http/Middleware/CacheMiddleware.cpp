@@ -0,0 +1,59 @@
+#include "CacheMiddleware.hpp"
+#include "RequestKey.hpp"
+
+CacheMiddleware::CacheMiddleware(Http::ResponseCache &cache, Http::CacheOptions options)
+    : cache(cache), options(std::move(options)) {}
+
+void CacheMiddleware::Handle(Http::Request &req, Http::Response &res, Next next)
+{
+    if (req.method != "GET")
+    {
+        next();
+        return;
+    }
+
+    std::string key = Http::RequestKey(req, res, options.vary);
+    auto now = Http::ResponseCache::Clock::now();
+
+    if (auto hit = cache.lookup(key, now))
+    {
+        res.serialized = std::move(hit);
+        return;
+    }
+
+    try
+    {
+        next();
+    }
+    catch (...)
+    {
+        cache.release(key);
+        throw;
+    }
+
+    if (isCacheable(res))
+    {
+        auto freshUntil = now + options.ttl;
+        cache.store(key, std::make_shared<const std::string>(res.toString()),
+                    freshUntil, freshUntil + options.staleWhileRevalidate);
+    }
+    else
+    {
+        cache.release(key);
+    }
+}
+
+bool CacheMiddleware::isCacheable(const Http::Response &res)
+{
+    if (res.statusCode != 200 || res.hasCookies() || res.serialized || res.pending || res.streaming)
+        return false;
+
+    const Http::Header *cacheControl = res.headers.find("Cache-Control");
+    if (cacheControl &&
+        (cacheControl->value.find("no-store") != std::string_view::npos || cacheControl->value.find("private") != std::string_view::npos))
+    {
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,12 @@
+#include "CoalesceMiddleware.hpp"
+
+CoalesceMiddleware::CoalesceMiddleware(Http::CoalesceOptions options)
+    : singleFlight(std::move(options)) {}
+
+void CoalesceMiddleware::Handle(Http::Request &req, Http::Response &res, Next next)
+{
+    singleFlight.run(req, res, [&]()
+                     {
+        next();
+        return true; });
+}
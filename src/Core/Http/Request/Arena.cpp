@@ -0,0 +1,34 @@
+#include "Arena.hpp"
+
+#include <cstring>
+
+namespace Http
+{
+    std::string_view Arena::copy(std::string_view bytes)
+    {
+        if (bytes.empty())
+            return {};
+
+        char *out = allocate(bytes.size());
+        std::memcpy(out, bytes.data(), bytes.size());
+        return std::string_view(out, bytes.size());
+    }
+
+    std::string_view Arena::join(std::initializer_list<std::string_view> parts)
+    {
+        size_t size = 0;
+        for (std::string_view part : parts)
+            size += part.size();
+        if (size == 0)
+            return {};
+
+        char *out = allocate(size);
+        char *cursor = out;
+        for (std::string_view part : parts)
+        {
+            std::memcpy(cursor, part.data(), part.size());
+            cursor += part.size();
+        }
+        return std::string_view(out, size);
+    }
+}
@@ -0,0 +1,169 @@
+#include "BodyStream.hpp"
+#include "EventLoop.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+#include <sys/socket.h>
+
+namespace Http
+{
+    namespace
+    {
+        // Longest a read waits for the client to send anything.
+        constexpr auto ReadTimeout = std::chrono::seconds(5);
+    }
+
+    BodyStream::BodyStream(int socket, size_t length, size_t chunkSize)
+        : socket(socket), length_(length), buffer(std::max<size_t>(chunkSize, 1))
+    {
+    }
+
+    BodyStream::BodyStream(int socket, ChunkedDecoder decoder, size_t chunkSize)
+        : socket(socket), length_(0), decoder(std::move(decoder)), buffer(std::max<size_t>(chunkSize, 1))
+    {
+    }
+
+    size_t BodyStream::prime(std::string_view bytes)
+    {
+        size_t share = std::min(bytes.size(), length_);
+        if (decoder)
+        {
+            // Walks the framing on a copy of the decoder to find where the
+            // body ends; the chunks themselves are decoded as they are read.
+            ChunkedDecoder probe = *decoder;
+            std::string_view data;
+            share = 0;
+            while (share < bytes.size() && !probe.done() && !probe.failed())
+                share += probe.decode(bytes.substr(share), data);
+            if (probe.failed())
+                share = bytes.size();
+        }
+
+        if (share > buffer.size())
+            buffer.resize(share);
+
+        std::memcpy(buffer.data(), bytes.data(), share);
+        start = 0;
+        end = share;
+        if (!decoder)
+            received_ += share;
+        return share;
+    }
+
+    const ChunkedDecoder::Fields &BodyStream::trailers() const
+    {
+        static const ChunkedDecoder::Fields none;
+        return decoder ? decoder->trailers() : none;
+    }
+
+    bool BodyStream::complete() const
+    {
+        if (decoder)
+            return decoder->done();
+        return received_ == length_ && start == end;
+    }
+
+    void BodyStream::decodeBuffered()
+    {
+        start += decoder->decode(std::string_view(buffer.data() + start, end - start), chunk);
+        if (decoder->failed())
+        {
+            throw std::runtime_error(decoder->error() == ChunkedDecoder::Error::Malformed
+                                         ? "malformed chunked request body"
+                                         : "request body chunk or trailers too large");
+        }
+        received_ += chunk.size();
+    }
+
+    bool BodyStream::fill()
+    {
+        while (chunk.empty() && !complete())
+        {
+            if (start < end)
+            {
+                if (decoder)
+                {
+                    decodeBuffered();
+                }
+                else
+                {
+                    chunk = std::string_view(buffer.data() + start, end - start);
+                    start = end;
+                }
+                continue;
+            }
+
+            // Never past the body: whatever follows it belongs to the next
+            // request and stays on the socket for the server.
+            size_t left = decoder ? decoder->remaining() : length_ - received_;
+            ssize_t n = recv(socket, buffer.data(), std::min(buffer.size(), left), 0);
+            if (n > 0)
+            {
+                start = 0;
+                end = n;
+                if (!decoder)
+                    received_ += n;
+                continue;
+            }
+            if (n == 0)
+                throw std::runtime_error("connection closed before the end of the request body");
+            if (errno == EINTR)
+                continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                throw std::system_error(errno, std::system_category(), "recv failed");
+            return false;
+        }
+        return true;
+    }
+
+    std::string_view BodyStream::take()
+    {
+        std::string_view next = chunk;
+        chunk = {};
+        return next;
+    }
+
+    bool BodyStream::ReadAwaiter::await_ready()
+    {
+        return stream.fill();
+    }
+
+    void BodyStream::ReadAwaiter::await_suspend(std::coroutine_handle<> handle)
+    {
+        wait(handle);
+    }
+
+    std::string_view BodyStream::ReadAwaiter::await_resume()
+    {
+        if (error)
+            std::rethrow_exception(error);
+        return stream.take();
+    }
+
+    Nerva::Detached BodyStream::ReadAwaiter::wait(std::coroutine_handle<> reader)
+    {
+        auto deadline = Nerva::EventLoop::Clock::now() + ReadTimeout;
+        try
+        {
+            // Woken by readiness or the deadline; either may find nothing
+            // to read, so the watch is armed again until the deadline passes.
+            do
+            {
+                if (Nerva::EventLoop::Clock::now() >= deadline)
+                    throw std::runtime_error("timed out reading the request body");
+                co_await Nerva::Readable(stream.socket, deadline);
+            } while (!stream.fill());
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+
+        // This awaiter is gone once reader resumes.
+        reader.resume();
+    }
+}
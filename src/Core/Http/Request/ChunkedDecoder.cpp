@@ -0,0 +1,221 @@
+#include "ChunkedDecoder.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace Http
+{
+    namespace
+    {
+        int hexValue(char c)
+        {
+            if (c >= '0' && c <= '9')
+                return c - '0';
+            if (c >= 'a' && c <= 'f')
+                return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F')
+                return c - 'A' + 10;
+            return -1;
+        }
+
+        std::string_view trim(std::string_view str)
+        {
+            size_t start = str.find_first_not_of(" \t");
+            if (start == std::string_view::npos)
+                return {};
+            return str.substr(start, str.find_last_not_of(" \t") - start + 1);
+        }
+    }
+
+    size_t ChunkedDecoder::decode(std::string_view input, std::string_view &data)
+    {
+        data = {};
+
+        size_t pos = 0;
+        while (pos < input.size())
+        {
+            char c = input[pos];
+
+            switch (state)
+            {
+            case State::Size:
+                if (++lineSize > MaxLineSize)
+                {
+                    fail(Error::Malformed);
+                    return pos;
+                }
+                if (int value = hexValue(c); value >= 0)
+                {
+                    if (size > (SIZE_MAX >> 4) ||
+                        (maxChunkSize && size * 16 + value > maxChunkSize))
+                    {
+                        fail(Error::ChunkTooLarge);
+                        return pos;
+                    }
+                    size = size * 16 + value;
+                    digits++;
+                }
+                else if (digits > 0 && (c == ';' || c == ' ' || c == '\t'))
+                {
+                    state = State::Extension;
+                }
+                else if (digits > 0 && c == '\r')
+                {
+                    state = State::SizeLF;
+                }
+                else
+                {
+                    fail(Error::Malformed);
+                    return pos;
+                }
+                break;
+
+            case State::Extension:
+                // Extensions are allowed and ignored, up to a line's worth.
+                if (c == '\r')
+                {
+                    state = State::SizeLF;
+                }
+                else if (++lineSize > MaxLineSize)
+                {
+                    fail(Error::Malformed);
+                    return pos;
+                }
+                break;
+
+            case State::SizeLF:
+                if (c != '\n')
+                {
+                    fail(Error::Malformed);
+                    return pos;
+                }
+                lineSize = 0;
+                state = size == 0 ? State::Trailer : State::Data;
+                break;
+
+            case State::Data:
+            {
+                size_t count = std::min(size, input.size() - pos);
+                data = input.substr(pos, count);
+                size -= count;
+                if (size == 0)
+                    state = State::DataCR;
+                return pos + count;
+            }
+
+            case State::DataCR:
+                if (c != '\r')
+                {
+                    fail(Error::Malformed);
+                    return pos;
+                }
+                state = State::DataLF;
+                break;
+
+            case State::DataLF:
+                if (c != '\n')
+                {
+                    fail(Error::Malformed);
+                    return pos;
+                }
+                digits = 0;
+                lineSize = 0;
+                state = State::Size;
+                break;
+
+            case State::Trailer:
+                if (c == '\r')
+                {
+                    state = State::TrailerLF;
+                }
+                else if (++trailerSize > MaxTrailerSize)
+                {
+                    fail(Error::TrailersTooLarge);
+                    return pos;
+                }
+                else
+                {
+                    line += c;
+                }
+                break;
+
+            case State::TrailerLF:
+                if (c != '\n' || !endTrailerLine())
+                {
+                    if (!failed())
+                        fail(Error::Malformed);
+                    return pos;
+                }
+                if (done())
+                    return pos + 1;
+                break;
+
+            case State::Done:
+            case State::Failed:
+                return pos;
+            }
+
+            pos++;
+        }
+
+        return pos;
+    }
+
+    bool ChunkedDecoder::endTrailerLine()
+    {
+        if (line.empty())
+        {
+            state = State::Done;
+            return true;
+        }
+
+        size_t colon = line.find(':');
+        if (colon == std::string::npos || colon == 0)
+            return false;
+
+        std::string_view field(line);
+        trailers_.emplace_back(std::string(field.substr(0, colon)), std::string(trim(field.substr(colon + 1))));
+        line.clear();
+        state = State::Trailer;
+        return true;
+    }
+
+    void ChunkedDecoder::fail(Error error)
+    {
+        error_ = error;
+        state = State::Failed;
+    }
+
+    size_t ChunkedDecoder::remaining() const
+    {
+        // The shortest ending from here is "0\r\n\r\n" for the last chunk,
+        // preceded by the rest of the current chunk and its CRLF.
+        const size_t lastChunk = 5;
+
+        switch (state)
+        {
+        case State::Size:
+            if (digits == 0)
+                return lastChunk;
+            return size == 0 ? 4 : 2 + size + 2 + lastChunk;
+        case State::Extension:
+            return size == 0 ? 4 : 2 + size + 2 + lastChunk;
+        case State::SizeLF:
+            return size == 0 ? 3 : 1 + size + 2 + lastChunk;
+        case State::Data:
+            return size + 2 + lastChunk;
+        case State::DataCR:
+            return 2 + lastChunk;
+        case State::DataLF:
+            return 1 + lastChunk;
+        case State::Trailer:
+            return line.empty() ? 2 : 4;
+        case State::TrailerLF:
+            return line.empty() ? 1 : 3;
+        case State::Done:
+        case State::Failed:
+            break;
+        }
+        return 0;
+    }
+}
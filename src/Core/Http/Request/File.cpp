@@ -0,0 +1,95 @@
+#include "File.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace Http
+{
+    namespace
+    {
+        bool writeAll(int fd, const char *bytes, size_t count)
+        {
+            while (count > 0)
+            {
+                ssize_t n = write(fd, bytes, count);
+                if (n < 0)
+                {
+                    if (errno == EINTR)
+                        continue;
+                    return false;
+                }
+                bytes += n;
+                count -= n;
+            }
+            return true;
+        }
+    }
+
+    File::File(const File &other)
+        : data_(other.data_), size_(other.size_), fd_(other.fd_), offset_(other.offset_), owner_(other.owner_)
+    {
+        if (!owner_ && data_)
+            ensureOwned();
+    }
+
+    File &File::operator=(const File &other)
+    {
+        if (this != &other)
+        {
+            data_ = other.data_;
+            size_ = other.size_;
+            fd_ = other.fd_;
+            offset_ = other.offset_;
+            owner_ = other.owner_;
+
+            if (!owner_ && data_)
+                ensureOwned();
+        }
+        return *this;
+    }
+
+    File File::slice(size_t offset, size_t size) const
+    {
+        offset = std::min(offset, size_);
+        size = std::min(size, size_ - offset);
+
+        File part(owner_, data_ + offset, size);
+        part.fd_ = fd_;
+        part.offset_ = offset_ + offset;
+        if (!owner_)
+            part.ensureOwned();
+        return part;
+    }
+
+    bool File::save(const std::string &path) const
+    {
+        if (!data_ || size_ == 0)
+            return false;
+
+        int out = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+        if (out == -1)
+            return false;
+
+        size_t copied = 0;
+        if (fd_ != -1)
+        {
+            off_t from = offset_;
+            while (copied < size_)
+            {
+                ssize_t n = copy_file_range(fd_, &from, out, nullptr, size_ - copied, 0);
+                if (n < 0 && errno == EINTR)
+                    continue;
+                // Unsupported here (e.g. across filesystems on older kernels):
+                // the rest is written from the mapping.
+                if (n <= 0)
+                    break;
+                copied += n;
+            }
+        }
+
+        bool saved = writeAll(out, data_ + copied, size_ - copied);
+        return close(out) == 0 && saved;
+    }
+}
@@ -0,0 +1,109 @@
+#include "HeaderList.hpp"
+
+#include <strings.h>
+
+namespace Http
+{
+    namespace
+    {
+        bool sameName(std::string_view a, std::string_view b)
+        {
+            return a.size() == b.size() && strncasecmp(a.data(), b.data(), a.size()) == 0;
+        }
+    }
+
+    HeaderList::HeaderList(const HeaderList &other)
+    {
+        for (const Header &header : other)
+            add(header.name, header.value);
+    }
+
+    HeaderList &HeaderList::operator=(const HeaderList &other)
+    {
+        if (this != &other)
+        {
+            clear();
+            for (const Header &header : other)
+                add(header.name, header.value);
+        }
+        return *this;
+    }
+
+    void HeaderList::set(std::string_view name, std::string_view value)
+    {
+        Header *headers = data();
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (sameName(headers[i].name, name))
+            {
+                headers[i].value = arena.copy(value);
+                return;
+            }
+        }
+        add(name, value);
+    }
+
+    void HeaderList::add(std::string_view name, std::string_view value)
+    {
+        push({arena.copy(name), arena.copy(value)});
+    }
+
+    void HeaderList::add(std::string_view name, std::initializer_list<std::string_view> valueParts)
+    {
+        push({arena.copy(name), arena.join(valueParts)});
+    }
+
+    const Header *HeaderList::find(std::string_view name) const
+    {
+        for (const Header &header : *this)
+        {
+            if (sameName(header.name, name))
+                return &header;
+        }
+        return nullptr;
+    }
+
+    size_t HeaderList::erase(std::string_view name)
+    {
+        size_t erased = 0;
+        while (const Header *header = find(name))
+        {
+            erase(header);
+            ++erased;
+        }
+        return erased;
+    }
+
+    void HeaderList::erase(const Header *header)
+    {
+        Header *headers = data();
+        size_t index = header - headers;
+        for (size_t i = index + 1; i < count; ++i)
+            headers[i - 1] = headers[i];
+
+        --count;
+        if (!overflow.empty())
+            overflow.pop_back();
+    }
+
+    void HeaderList::clear()
+    {
+        count = 0;
+        overflow.clear();
+        arena.reset();
+    }
+
+    void HeaderList::push(Header header)
+    {
+        if (overflow.empty() && count < InlineCount)
+        {
+            inlineHeaders[count++] = header;
+            return;
+        }
+
+        if (overflow.empty())
+            overflow.assign(inlineHeaders, inlineHeaders + count);
+        overflow.push_back(header);
+        ++count;
+    }
+}
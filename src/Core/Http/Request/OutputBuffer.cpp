@@ -0,0 +1,125 @@
+#include "OutputBuffer.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace Http
+{
+    OutputBuffer::OutputBuffer(const OutputBuffer &other)
+        : segments(other.segments), blocks(other.blocks), owners(other.owners), total(other.total)
+    {
+        // Blocks are shared with other, so neither side may write into them.
+    }
+
+    OutputBuffer &OutputBuffer::operator=(const OutputBuffer &other)
+    {
+        if (this != &other)
+        {
+            segments = other.segments;
+            blocks = other.blocks;
+            owners = other.owners;
+            total = other.total;
+            cursor = nullptr;
+            available = 0;
+        }
+        return *this;
+    }
+
+    void OutputBuffer::append(std::string_view bytes)
+    {
+        if (bytes.empty())
+            return;
+
+        total += bytes.size();
+
+        while (!bytes.empty())
+        {
+            if (available == 0)
+            {
+                size_t blockSize = std::max(BlockSize, bytes.size());
+                blocks.push_back({std::shared_ptr<char[]>(new char[blockSize]), blockSize});
+                cursor = blocks.back().data.get();
+                available = blockSize;
+            }
+
+            size_t n = std::min(available, bytes.size());
+            std::memcpy(cursor, bytes.data(), n);
+
+            if (!segments.empty() && segments.back().data + segments.back().size == cursor)
+                segments.back().size += n;
+            else
+                segments.push_back({cursor, n});
+
+            cursor += n;
+            available -= n;
+            bytes.remove_prefix(n);
+        }
+    }
+
+    void OutputBuffer::reference(std::string_view bytes)
+    {
+        if (bytes.size() < ReferenceThreshold)
+        {
+            append(bytes);
+            return;
+        }
+
+        segments.push_back({bytes.data(), bytes.size()});
+        total += bytes.size();
+    }
+
+    void OutputBuffer::retain(std::shared_ptr<const void> owner)
+    {
+        for (const auto &held : owners)
+        {
+            if (held == owner)
+                return;
+        }
+        owners.push_back(std::move(owner));
+    }
+
+    void OutputBuffer::clear()
+    {
+        segments.clear();
+        blocks.clear();
+        cursor = nullptr;
+        available = 0;
+        total = 0;
+    }
+
+    void OutputBuffer::reset()
+    {
+        Block first;
+        if (!blocks.empty() && blocks.front().data.use_count() == 1)
+            first = std::move(blocks.front());
+
+        clear();
+        owners.clear();
+
+        if (first.data)
+        {
+            cursor = first.data.get();
+            available = first.size;
+            blocks.push_back(std::move(first));
+        }
+    }
+
+    std::string OutputBuffer::str() const
+    {
+        std::string result;
+        result.reserve(total);
+        for (const Segment &segment : segments)
+        {
+            result.append(segment.data, segment.size);
+        }
+        return result;
+    }
+
+    void OutputBuffer::gather(std::vector<iovec> &iov) const
+    {
+        for (const Segment &segment : segments)
+        {
+            iov.push_back({const_cast<char *>(segment.data), segment.size});
+        }
+    }
+}
@@ -1,39 +1,110 @@
 #include "Request.hpp"
 
-bool Http::Request::parse(const std::string &rawRequest)
+#include <charconv>
+
+namespace
+{
+    bool takeLine(std::string_view &rest, std::string_view &line)
+    {
+        if (rest.empty())
+            return false;
+
+        size_t end = rest.find('\n');
+        line = rest.substr(0, end);
+        rest = end == std::string_view::npos ? std::string_view() : rest.substr(end + 1);
+        return true;
+    }
+
+    std::string_view takeWord(std::string_view &rest)
+    {
+        size_t start = rest.find_first_not_of(" \t\r");
+        if (start == std::string_view::npos)
+        {
+            rest = {};
+            return {};
+        }
+
+        size_t end = rest.find_first_of(" \t\r", start);
+        std::string_view word = rest.substr(start, end - start);
+        rest = end == std::string_view::npos ? std::string_view() : rest.substr(end);
+        return word;
+    }
+
+    std::string_view trim(std::string_view str, const char *whitespace)
+    {
+        size_t start = str.find_first_not_of(whitespace);
+        if (start == std::string_view::npos)
+            return {};
+        return str.substr(start, str.find_last_not_of(whitespace) - start + 1);
+    }
+
+    // map[key] = value, with the key built on the map's own resource.
+    template <typename T, typename V>
+    void store(Http::StringMap<T> &map, std::string_view key, V &&value)
+    {
+        map.insert_or_assign(std::pmr::string(key, map.get_allocator()), std::forward<V>(value));
+    }
+}
+
+bool Http::Request::parse(std::string_view rawRequest)
+{
+    std::string_view rest = rawRequest;
+    if (!parseHead(rest))
+        return false;
+
+    // Files from an earlier body may still share its buffer.
+    if (!bodyBuffer || bodyBuffer.use_count() > 1)
+        bodyBuffer = std::make_shared<std::vector<char>>();
+    bodyBuffer->assign(rest.begin(), rest.end());
+    body = File(bodyBuffer, bodyBuffer->data(), bodyBuffer->size());
+
+    return parseBody();
+}
+
+bool Http::Request::parse(std::string_view head, File body)
+{
+    if (!parseHead(head))
+        return false;
+
+    this->body = std::move(body);
+    return parseBody();
+}
+
+bool Http::Request::parseHead(std::string_view &rest)
 {
-    std::istringstream stream(rawRequest);
-    std::string requestLine;
+    std::string_view requestLine;
 
-    if (!std::getline(stream, requestLine))
+    if (!takeLine(rest, requestLine))
         return false;
 
-    std::istringstream lineStream(requestLine);
-    if (!(lineStream >> method >> path >> version))
+    std::string_view methodWord = takeWord(requestLine);
+    std::string_view pathWord = takeWord(requestLine);
+    std::string_view versionWord = takeWord(requestLine);
+    if (versionWord.empty())
         return false;
 
-    std::string headerLine;
-    while (std::getline(stream, headerLine))
+    method.assign(methodWord);
+    path.assign(pathWord);
+    version.assign(versionWord);
+
+    std::string_view headerLine;
+    while (takeLine(rest, headerLine))
     {
         if (headerLine.empty() || headerLine == "\r")
             break;
 
         size_t colonPos = headerLine.find(':');
-        if (colonPos != std::string::npos)
+        if (colonPos != std::string_view::npos)
         {
-            std::string key = headerLine.substr(0, colonPos);
-            std::string value = headerLine.substr(colonPos + 1);
-
-            value.erase(0, value.find_first_not_of(" \t\r\n"));
-            value.erase(value.find_last_not_of(" \t\r\n") + 1);
-
-            headers[key] = value;
+            store(headers, headerLine.substr(0, colonPos), trim(headerLine.substr(colonPos + 1), " \t\r\n"));
         }
     }
 
-    raw_data.assign(std::istreambuf_iterator<char>(stream),
-                    std::istreambuf_iterator<char>());
+    return true;
+}
 
+bool Http::Request::parseBody()
+{
     if (isMultipartFormData())
     {
         if (!parseMultipartFormData())
@@ -53,72 +124,110 @@ bool Http::Request::parse(const std::string &rawRequest)
     return true;
 }
 
+void Http::Request::reset()
+{
+    method.clear();
+    path.clear();
+    version.clear();
+    pathOffset = 0;
+    ip.clear();
+    ipv6.clear();
+
+    // Drop this request's own slices of bodyBuffer first, so that only
+    // files a handler kept hold it and force a fresh buffer.
+    body = File();
+    formData.clear();
+    jsonBody = nullptr;
+    bodyStream.reset();
+    trailers.clear();
+    if (bodyBuffer && (bodyBuffer.use_count() > 1 || bodyBuffer->capacity() > RequestArena::LargestPooledBlock))
+        bodyBuffer.reset();
+
+    headers.clear();
+    params.clear();
+    captures = {};
+    query.clear();
+    has_json_body = false;
+}
+
 bool Http::Request::isMultipartFormData() const
 {
-    auto it = headers.find("Content-Type");
-    return it != headers.end() &&
-           it->second.find("multipart/form-data") != std::string::npos;
+    return getHeader("Content-Type").find("multipart/form-data") != std::string_view::npos;
 }
 
-const std::string &Http::Request::getParam(const std::string &key) const
+std::string_view Http::Request::getParam(std::string_view key) const
 {
-    static const std::string empty = "";
     auto it = params.find(key);
-    return it != params.end() ? it->second : empty;
+    return it != params.end() ? std::string_view(it->second) : std::string_view();
 }
 
-const std::string &Http::Request::getQuery(const std::string &key) const
+std::string_view Http::Request::getQuery(std::string_view key) const
 {
-    static const std::string empty = "";
     auto it = query.find(key);
-    return it != query.end() ? it->second : empty;
+    return it != query.end() ? std::string_view(it->second) : std::string_view();
 }
 
-const std::string &Http::Request::getHeader(const std::string &key) const
+std::string_view Http::Request::getHeader(std::string_view key) const
 {
-    static const std::string empty = "";
     auto it = headers.find(key);
-    return it != headers.end() ? it->second : empty;
+    return it != headers.end() ? std::string_view(it->second) : std::string_view();
 }
 
-const Http::Request::FormData &Http::Request::getFormData(const std::string &key) const
+std::string_view Http::Request::getTrailer(std::string_view key) const
+{
+    const ChunkedDecoder::Fields &fields = isStreaming() ? bodyStream->trailers() : trailers;
+    for (const auto &[name, value] : fields)
+    {
+        if (name == key)
+            return value;
+    }
+    return std::string_view();
+}
+
+void Http::Request::setParam(std::string_view key, std::string_view value)
+{
+    store(params, key, value);
+}
+
+const Http::Request::FormData &Http::Request::getFormData(std::string_view key) const
 {
     static const FormData empty = {"", File(), "", "", false};
-    
+
     auto it = formData.find(key);
     if (it != formData.end()) {
         return it->second;
     }
-    
+
     auto paramIt = params.find(key);
     if (paramIt != params.end()) {
         static FormData tempData;
-        tempData.value = paramIt->second;
+        tempData.value.assign(paramIt->second);
         tempData.isFile = false;
         tempData.filename = "";
         tempData.contentType = "";
         tempData.file = File();
         return tempData;
     }
-    
+
     return empty;
 }
 
 bool Http::Request::parseMultipartFormData()
 {
-    const std::string &contentType = headers["Content-Type"];
+    std::string_view contentType = getHeader("Content-Type");
     size_t boundaryPos = contentType.find("boundary=");
-    if (boundaryPos == std::string::npos)
+    if (boundaryPos == std::string_view::npos)
         return false;
 
-    std::string boundary = "--" + contentType.substr(boundaryPos + 9);
-    std::string body(raw_data.begin(), raw_data.end());
+    String boundary("--", resource());
+    boundary.append(contentType.substr(boundaryPos + 9));
+    std::string_view body = this->body.view();
 
     size_t pos = 0;
     while (pos < body.size())
     {
         size_t boundaryStart = body.find(boundary, pos);
-        if (boundaryStart == std::string::npos)
+        if (boundaryStart == std::string_view::npos)
             break;
 
         size_t partStart = boundaryStart + boundary.size();
@@ -129,26 +238,26 @@ bool Http::Request::parseMultipartFormData()
             break;
 
         partStart = body.find("\r\n", partStart);
-        if (partStart == std::string::npos)
+        if (partStart == std::string_view::npos)
             break;
         partStart += 2;
 
         size_t headersEnd = body.find("\r\n\r\n", partStart);
-        if (headersEnd == std::string::npos)
+        if (headersEnd == std::string_view::npos)
             break;
 
-        std::string partHeaders = body.substr(partStart, headersEnd - partStart);
+        std::string_view partHeaders = body.substr(partStart, headersEnd - partStart);
         size_t contentStart = headersEnd + 4;
 
         size_t partEnd = body.find(boundary, contentStart);
-        if (partEnd == std::string::npos)
+        if (partEnd == std::string_view::npos)
             partEnd = body.size();
 
         size_t contentEnd = (partEnd >= 2) ? partEnd - 2 : partEnd;
         if (contentEnd < contentStart)
             contentEnd = contentStart;
 
-        if (!parseFormDataPart(partHeaders, raw_data.data() + contentStart, contentEnd - contentStart))
+        if (!parseFormDataPart(partHeaders, contentStart, contentEnd - contentStart))
             return false;
 
         pos = partEnd;
@@ -157,98 +266,93 @@ bool Http::Request::parseMultipartFormData()
     return true;
 }
 
-bool Http::Request::parseFormDataPart(const std::string &headers, const char* content, size_t contentSize)
+bool Http::Request::parseFormDataPart(std::string_view headers, size_t contentStart, size_t contentSize)
 {
     size_t dispPos = headers.find("Content-Disposition:");
-    if (dispPos == std::string::npos)
+    if (dispPos == std::string_view::npos)
         return false;
 
     size_t namePos = headers.find("name=\"", dispPos);
-    if (namePos == std::string::npos)
+    if (namePos == std::string_view::npos)
         return false;
 
     namePos += 6;
     size_t nameEnd = headers.find("\"", namePos);
-    if (nameEnd == std::string::npos)
+    if (nameEnd == std::string_view::npos)
         return false;
 
-    std::string name = headers.substr(namePos, nameEnd - namePos);
+    std::string_view name = headers.substr(namePos, nameEnd - namePos);
     FormData data;
 
     size_t filenamePos = headers.find("filename=\"", dispPos);
-    if (filenamePos != std::string::npos)
+    if (filenamePos != std::string_view::npos)
     {
         filenamePos += 10;
         size_t filenameEnd = headers.find("\"", filenamePos);
-        if (filenameEnd == std::string::npos)
+        if (filenameEnd == std::string_view::npos)
             return false;
 
-        data.filename = headers.substr(filenamePos, filenameEnd - filenamePos);
+        data.filename = std::string(headers.substr(filenamePos, filenameEnd - filenamePos));
         data.isFile = true;
 
         size_t ctPos = headers.find("Content-Type:");
-        if (ctPos != std::string::npos)
+        if (ctPos != std::string_view::npos)
         {
             ctPos += 13;
             size_t ctEnd = headers.find("\r\n", ctPos);
-            data.contentType = headers.substr(ctPos, ctEnd - ctPos);
-
-            data.contentType.erase(0, data.contentType.find_first_not_of(" \t"));
-            data.contentType.erase(data.contentType.find_last_not_of(" \t") + 1);
+            data.contentType = std::string(trim(headers.substr(ctPos, ctEnd - ctPos), " \t"));
         }
 
-        data.file = File(content, contentSize);
+        data.file = body.slice(contentStart, contentSize);
     }
     else
     {
-        data.value = std::string(content, contentSize);
+        data.value = std::string(body.view().substr(contentStart, contentSize));
         data.isFile = false;
     }
 
-    formData[name] = data;
+    store(formData, name, std::move(data));
     return true;
 }
 
 void Http::Request::parseQueryParameters()
 {
     size_t queryPos = path.find('?');
-    if (queryPos == std::string::npos)
+    if (queryPos == String::npos)
         return;
 
-    std::string queryStr = path.substr(queryPos + 1);
-    path = path.substr(0, queryPos);
+    std::string_view queryStr = std::string_view(path).substr(queryPos + 1);
 
     size_t start = 0;
     while (start < queryStr.size())
     {
         size_t end = queryStr.find('&', start);
-        if (end == std::string::npos)
+        if (end == std::string_view::npos)
             end = queryStr.size();
 
         size_t eq = queryStr.find('=', start);
-        if (eq != std::string::npos && eq < end)
+        if (eq != std::string_view::npos && eq < end)
         {
-            std::string key = queryStr.substr(start, eq - start);
-            std::string value = queryStr.substr(eq + 1, end - eq - 1);
-            query[key] = value;
+            store(query, queryStr.substr(start, eq - start), queryStr.substr(eq + 1, end - eq - 1));
         }
         else
         {
-            std::string key = queryStr.substr(start, end - start);
-            query[key] = "";
+            store(query, queryStr.substr(start, end - start), "");
         }
         start = end + 1;
     }
+
+    path.resize(queryPos);
 }
 
-std::vector<std::string> Http::Request::split(const std::string &str, char delim)
+std::vector<std::string_view> Http::Request::split(std::string_view str, char delim)
 {
-    std::vector<std::string> parts;
+    std::vector<std::string_view> parts;
     size_t start = 0;
     while (true)
     {
         size_t pos = str.find(delim, start);
-        if (pos == std::string::npos)
+        if (pos == std::string_view::npos)
         {
             parts.push_back(str.substr(start));
             break;
@@ -259,7 +363,7 @@ std::vector<std::string> Http::Request::split(const std::string &str, char delim
     return parts;
 }
 
-bool Http::Request::matchRouteAndExtractParams(const std::string &routePattern)
+bool Http::Request::matchRouteAndExtractParams(std::string_view routePattern)
 {
     auto routeParts = split(routePattern, '/');
     auto pathParts = split(path, '/');
@@ -271,8 +375,7 @@ bool Http::Request::matchRouteAndExtractParams(const std::string &routePattern)
     {
         if (!routeParts[i].empty() && routeParts[i][0] == ':')
         {
-            std::string key = routeParts[i].substr(1);
-            params[key] = pathParts[i];
+            setParam(routeParts[i].substr(1), pathParts[i]);
         }
         else if (routeParts[i] != pathParts[i])
         {
@@ -284,40 +387,35 @@ bool Http::Request::matchRouteAndExtractParams(const std::string &routePattern)
 
 bool Http::Request::isUrlEncodedFormData() const
 {
-    auto it = headers.find("Content-Type");
-    return it != headers.end() &&
-           it->second.find("application/x-www-form-urlencoded") != std::string::npos;
+    return getHeader("Content-Type").find("application/x-www-form-urlencoded") != std::string_view::npos;
 }
 
 void Http::Request::parseUrlEncodedFormData()
 {
-    std::string body(raw_data.begin(), raw_data.end());
+    std::string_view body = this->body.view();
     size_t start = 0;
     while (start < body.size())
     {
         size_t end = body.find('&', start);
-        if (end == std::string::npos)
+        if (end == std::string_view::npos)
             end = body.size();
 
         size_t eq = body.find('=', start);
-        if (eq != std::string::npos && eq < end)
+        if (eq != std::string_view::npos && eq < end)
         {
-            std::string key = body.substr(start, eq - start);
-            std::string value = body.substr(eq + 1, end - eq - 1);
-            params[key] = urlDecode(value);
+            store(params, body.substr(start, eq - start), urlDecode(body.substr(eq + 1, end - eq - 1)));
         }
         else
         {
-            std::string key = body.substr(start, end - start);
-            params[key] = "";
+            store(params, body.substr(start, end - start), "");
         }
         start = end + 1;
     }
 }
 
-std::string Http::Request::urlDecode(const std::string &str)
+Http::Request::String Http::Request::urlDecode(std::string_view str)
 {
-    std::string result;
+    String result(resource());
     result.reserve(str.size());
     for (size_t i = 0; i < str.size(); ++i)
     {
@@ -328,8 +426,7 @@ std::string Http::Request::urlDecode(const std::string &str)
         else if (str[i] == '%' && i + 2 < str.size())
         {
             int value;
-            std::istringstream iss(str.substr(i + 1, 2));
-            if (iss >> std::hex >> value)
+            if (std::from_chars(str.data() + i + 1, str.data() + i + 3, value, 16).ec == std::errc())
             {
                 result += static_cast<char>(value);
                 i += 2;
@@ -347,38 +444,37 @@ std::string Http::Request::urlDecode(const std::string &str)
     return result;
 }
 
-bool Http::Request::hasParam(const std::string &key) const
+bool Http::Request::hasParam(std::string_view key) const
 {
     return params.find(key) != params.end();
 }
 
-bool Http::Request::hasQuery(const std::string &key) const
+bool Http::Request::hasQuery(std::string_view key) const
 {
     return query.find(key) != query.end();
 }
 
-bool Http::Request::hasHeader(const std::string &key) const
+bool Http::Request::hasHeader(std::string_view key) const
 {
     return headers.find(key) != headers.end();
 }
 
-bool Http::Request::hasFormData(const std::string &key) const
+bool Http::Request::hasFormData(std::string_view key) const
 {
     return formData.find(key) != formData.end();
 }
 
 bool Http::Request::isJsonData() const
 {
-    auto it = headers.find("Content-Type");
-    return it != headers.end() &&
-           it->second.find("application/json") != std::string::npos;
+    return getHeader("Content-Type").find("application/json") != std::string_view::npos;
 }
 
 void Http::Request::parseJsonData()
 {
     try
     {
-        jsonBody = nlohmann::json::parse(raw_data);
+        std::string_view text = body.view();
+        jsonBody = nlohmann::json::parse(text.begin(), text.end());
         has_json_body = true;
     }
     catch (...)
@@ -395,4 +491,4 @@ const nlohmann::json &Http::Request::getJson() const
 bool Http::Request::hasJsonBody() const
 {
     return has_json_body;
-}
\ No newline at end of file
+}
@@ -1,7 +1,301 @@
 #include "Response.hpp"
 #include "StaticFileHandler.hpp"
 
+#include "EventLoop.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <stdexcept>
+#include <sys/socket.h>
+
+namespace
+{
+    // Sends what the socket takes without waiting and leaves the rest in
+    // iov; returns how much went out, or -1 if the connection failed.
+    ssize_t sendSome(int socket, std::vector<iovec> &iov)
+    {
+        size_t total = 0;
+        size_t next = 0;
+        while (next < iov.size())
+        {
+            struct msghdr msg = {};
+            msg.msg_iov = iov.data() + next;
+            msg.msg_iovlen = std::min<size_t>(iov.size() - next, IOV_MAX);
+
+            ssize_t sent = sendmsg(socket, &msg, MSG_DONTWAIT | MSG_NOSIGNAL);
+            if (sent < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK)
+                    break;
+                return -1;
+            }
+
+            total += sent;
+            while (next < iov.size() && static_cast<size_t>(sent) >= iov[next].iov_len)
+            {
+                sent -= iov[next].iov_len;
+                iov[next++].iov_len = 0;
+            }
+            if (next < iov.size())
+            {
+                iov[next].iov_base = static_cast<char *>(iov[next].iov_base) + sent;
+                iov[next].iov_len -= sent;
+            }
+        }
+        return total;
+    }
+}
+
 void Http::Response::SendFile(std::string path)
 {
     ::StaticFileHandler::SendFile(path, *this);
 }
+
+void Http::Response::reset()
+{
+    statusCode = 200;
+    statusMessage = "OK";
+    headers.clear();
+
+    if (body.capacity() > RequestArena::LargestPooledBlock)
+        std::string().swap(body);
+    else
+        body.clear();
+
+    output.reset();
+    incomingCookies.clear();
+    serialized.reset();
+    transport = nullptr;
+    connection = -1;
+    streaming = false;
+    ended = false;
+    backlog.clear();
+    broken = false;
+    pending.reset();
+}
+
+Http::Response &Http::Response::setCookie(const std::string &name,
+                                          const std::string &value,
+                                          const CookieOptions &options)
+{
+    char maxAge[24];
+    char expires[64];
+    std::string_view maxAgeText, expiresText;
+
+    if (options.maxAge)
+    {
+        auto result = std::to_chars(maxAge, maxAge + sizeof(maxAge), options.maxAge->count());
+        maxAgeText = std::string_view(maxAge, result.ptr - maxAge);
+
+        std::time_t expireTime = std::time(nullptr) + options.maxAge->count();
+        std::tm tm;
+        gmtime_r(&expireTime, &tm);
+        expiresText = std::string_view(expires, std::strftime(expires, sizeof(expires), "%a, %d %b %Y %H:%M:%S GMT", &tm));
+    }
+
+    for (const Header &header : headers)
+    {
+        if (header.name == "Set-Cookie" && header.value.size() > name.size() &&
+            header.value.compare(0, name.size(), name) == 0 && header.value[name.size()] == '=')
+        {
+            headers.erase(&header);
+            break;
+        }
+    }
+
+    headers.add("Set-Cookie", {name, "=", value,
+                               options.maxAge ? "; Max-Age=" : "", maxAgeText,
+                               options.maxAge ? "; Expires=" : "", expiresText,
+                               options.path ? "; Path=" : "", options.path ? std::string_view(*options.path) : "",
+                               options.domain ? "; Domain=" : "", options.domain ? std::string_view(*options.domain) : "",
+                               options.secure ? "; Secure" : "",
+                               options.httpOnly ? "; HttpOnly" : "",
+                               options.sameSite ? "; SameSite=" : "", options.sameSite ? std::string_view(*options.sameSite) : ""});
+    return *this;
+}
+
+void Http::Response::writeHead(std::string &head, bool chunked) const
+{
+    char number[24];
+
+    head.append("HTTP/1.1 ");
+    head.append(number, std::to_chars(number, number + sizeof(number), statusCode).ptr - number);
+    head.append(" ").append(statusMessage).append("\r\n");
+
+    if (!headers.contains("Content-Type"))
+    {
+        std::string_view start = body.empty() ? output.front() : std::string_view(body);
+        head.append("Content-Type: ").append(detectContentType(start)).append("\r\n");
+    }
+
+    // A handler may set Content-Length itself (e.g. for HEAD); a chunked
+    // response must not carry one.
+    const Header *length = headers.find("Content-Length");
+    for (const Header &header : headers)
+    {
+        if (chunked && &header == length)
+            continue;
+        head.append(header.name).append(": ").append(header.value).append("\r\n");
+    }
+
+    if (chunked)
+    {
+        head.append("Transfer-Encoding: chunked\r\n");
+    }
+    else if (!length)
+    {
+        head.append("Content-Length: ");
+        head.append(number, std::to_chars(number, number + sizeof(number), body.size() + output.size()).ptr - number);
+        head.append("\r\n");
+    }
+    head.append("Connection: keep-alive\r\n\r\n");
+}
+
+void Http::Response::frame(std::string &prefix, std::vector<iovec> &iov)
+{
+    size_t length = body.size() + output.size();
+    if (!streaming)
+        writeHead(prefix, true);
+    if (length)
+    {
+        char sizeLine[32];
+        prefix.append(sizeLine, snprintf(sizeLine, sizeof(sizeLine), "%zx\r\n", length));
+    }
+
+    if (!prefix.empty())
+        iov.push_back({prefix.data(), prefix.size()});
+    if (!body.empty())
+        iov.push_back({body.data(), body.size()});
+    output.gather(iov);
+    if (length)
+        iov.push_back({const_cast<char *>("\r\n"), 2});
+
+    streaming = true;
+}
+
+bool Http::Response::flush()
+{
+    if (!transport)
+        return false;
+
+    if (streaming && body.empty() && output.empty() && backlog.empty())
+        return !broken;
+
+    std::string prefix;
+    std::vector<iovec> iov;
+    if (!backlog.empty())
+        iov.push_back({backlog.data(), backlog.size()});
+    frame(prefix, iov);
+
+    bool sent = !broken && transport(iov);
+    broken = !sent;
+
+    backlog.clear();
+    body.clear();
+    output.clear();
+    return sent;
+}
+
+bool Http::Response::end()
+{
+    if (ended)
+        return !broken;
+    if (!flush())
+        return false;
+
+    ended = true;
+    std::vector<iovec> iov{{const_cast<char *>("0\r\n\r\n"), 5}};
+    return transport(iov);
+}
+
+void Http::Response::queueEnd()
+{
+    if (ended)
+        return;
+
+    std::string prefix;
+    std::vector<iovec> iov;
+    if (!streaming || !body.empty() || !output.empty())
+        frame(prefix, iov);
+    iov.push_back({const_cast<char *>("0\r\n\r\n"), 5});
+    ended = true;
+
+    queue(iov);
+    body.clear();
+    output.clear();
+}
+
+bool Http::Response::write(std::string_view chunk)
+{
+    if (ended)
+        return false;
+
+    output.append(chunk);
+    if (!transport)
+        return true;
+
+    if (streaming && body.size() + output.size() < WriteWatermark)
+        return backlog.empty() && !broken;
+
+    return sendChunk();
+}
+
+bool Http::Response::sendChunk()
+{
+    std::string prefix;
+    std::vector<iovec> iov;
+    frame(prefix, iov);
+    queue(iov);
+
+    body.clear();
+    output.clear();
+    return backlog.empty() && !broken;
+}
+
+void Http::Response::queue(std::vector<iovec> &iov)
+{
+    // Behind a backlog the socket was full a moment ago, so iov just queues
+    // up after it.
+    if (backlog.empty() && !broken && connection != -1)
+        broken = sendSome(connection, iov) < 0;
+
+    if (!broken)
+    {
+        for (const iovec &part : iov)
+            backlog.append(static_cast<const char *>(part.iov_base), part.iov_len);
+    }
+}
+
+void Http::Response::sendBacklog()
+{
+    std::vector<iovec> iov{{backlog.data(), backlog.size()}};
+    ssize_t sent = sendSome(connection, iov);
+    if (sent < 0)
+    {
+        broken = true;
+        backlog.clear();
+        return;
+    }
+    backlog.erase(0, sent);
+}
+
+Nerva::Detached Http::Response::drainBacklog(std::coroutine_handle<> waiter)
+{
+    while (!backlog.empty() && !broken)
+    {
+        co_await Nerva::Writable(connection);
+        sendBacklog();
+    }
+    waiter.resume();
+}
+
+void Http::Response::DrainAwaiter::await_resume() const
+{
+    if (res.broken)
+        throw std::runtime_error("connection closed while streaming the response");
+}
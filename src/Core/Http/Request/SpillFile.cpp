@@ -0,0 +1,71 @@
+#include "SpillFile.hpp"
+
+#include <cerrno>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace Http
+{
+    std::shared_ptr<SpillFile> SpillFile::Create()
+    {
+        std::error_code ec;
+        std::string directory = std::filesystem::temp_directory_path(ec).string();
+        if (ec)
+            directory = "/tmp";
+
+        int fd = open(directory.c_str(), O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+        if (fd == -1)
+        {
+            // Filesystems without O_TMPFILE: a named file, unlinked at once.
+            std::string name = directory + "/nerva-body-XXXXXX";
+            fd = mkostemp(name.data(), O_CLOEXEC);
+            if (fd == -1)
+                return nullptr;
+            unlink(name.c_str());
+        }
+
+        return std::shared_ptr<SpillFile>(new SpillFile(fd));
+    }
+
+    SpillFile::~SpillFile()
+    {
+        if (mapping)
+            munmap(mapping, written);
+        close(descriptor);
+    }
+
+    bool SpillFile::append(const char *bytes, size_t count)
+    {
+        while (count > 0)
+        {
+            ssize_t n = write(descriptor, bytes, count);
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                return false;
+            }
+            bytes += n;
+            count -= n;
+            written += n;
+        }
+        return true;
+    }
+
+    bool SpillFile::map()
+    {
+        if (written == 0)
+            return true;
+
+        void *mapped = mmap(nullptr, written, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if (mapped == MAP_FAILED)
+            return false;
+
+        mapping = static_cast<char *>(mapped);
+        return true;
+    }
+}
@@ -3,6 +3,9 @@
 #include "RouteBuilder.hpp"
 #include "Router.hpp"
 #include "Middleware.hpp"
+#include "CacheMiddleware.hpp"
+#include "CoalesceMiddleware.hpp"
+#include "AsyncHandler.hpp"
 
 RouteBuilder::RouteBuilder(Router &router, std::string method, std::string path)
     : router(router), method(std::move(method)), path(std::move(path)) {}
@@ -13,7 +16,33 @@ RouteBuilder &RouteBuilder::Use(IHandler &middleware)
     return *this;
 }
 
+RouteBuilder &RouteBuilder::Cache(const Http::CacheOptions &options)
+{
+    auto cache = std::make_unique<CacheMiddleware>(Http::ResponseCache::Shared(), options);
+    middlewares.push_back(router.ownHandler(std::move(cache)));
+    return *this;
+}
+
+RouteBuilder &RouteBuilder::Coalesce(const Http::CoalesceOptions &options)
+{
+    middlewares.push_back(router.ownHandler(std::make_unique<CoalesceMiddleware>(options)));
+    return *this;
+}
+
+RouteBuilder &RouteBuilder::Stream()
+{
+    streaming = true;
+    return *this;
+}
+
 void RouteBuilder::Then(RequestHandler handler)
 {
+    if (streaming)
+        router.addStreamingRoute(method, path);
     router.addRoute(middlewares, method, path, handler);
-}
\ No newline at end of file
+}
+
+void RouteBuilder::Then(AsyncHandler handler)
+{
+    Then(Nerva::Async(std::move(handler)));
+}
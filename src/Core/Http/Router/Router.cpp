@@ -12,6 +12,32 @@ void Router::addRoute(const std::vector<std::reference_wrapper<IHandler>> &middl
     routes.insert(middlewares, method, path, handler);
 }
 
+void Router::addStreamingRoute(const std::string &method, const std::string &path)
+{
+    streamingRoutes.insert({}, method, path, RequestHandler());
+}
+
+bool Router::streamsBody(const std::string &method, std::string_view path) const
+{
+    RadixNode::Params params;
+    if (streamingRoutes.find(method, path, params).has_value())
+        return true;
+
+    std::vector<MountTrie::Mount> matched;
+    mounts.match(path, matched);
+    for (const auto &mount : matched)
+    {
+        auto *group = dynamic_cast<const Router *>(mount.handler);
+        if (!group || mount.wildcard)
+            continue;
+
+        std::string_view rest = path.size() > mount.prefixLength ? path.substr(mount.prefixLength) : "/";
+        if (group->streamsBody(method, rest))
+            return true;
+    }
+    return false;
+}
+
 void Router::Get(const std::string &path, const std::vector<std::reference_wrapper<IHandler>> middlewares, const RequestHandler &handler)
 {
     addRoute(middlewares, "GET", path, handler);
@@ -62,11 +88,12 @@ void Router::Set(std::string key, Nerva::TemplateEngine *value)
     _engine = value;
 }
 
-bool Router::tryDispatch(const std::string &fullPath, Http::Request &req, Http::Response &res) const
+bool Router::tryDispatch(std::string_view fullPath, Http::Request &req, Http::Response &res) const
 {
-    std::map<std::string, std::string> params;
+    RadixNode::Params params;
+    bool typed = false;
 
-    auto result = routes.find(req.method, fullPath, params);
+    auto result = routes.find(req.method, fullPath, params, &typed);
 
     if (!result.has_value())
     {
@@ -78,15 +105,23 @@ bool Router::tryDispatch(const std::string &fullPath, Http::Request &req, Http::
     {
         auto [firstHandler, middlewares] = result.value();
 
-        for (const auto &[key, value] : params)
+        if (typed)
+        {
+            req.captures = params;
+        }
+        else
         {
-            req.params[key] = value;
+            for (const auto &[key, value] : params)
+            {
+                req.setParam(key, value);
+            }
         }
 
         auto allHandlers = routes.getAllHandlers(req.method, fullPath);
         
         if (allHandlers.empty())
         {
+            req.captures = {};
             auto wildcardResult = routes.find(req.method, "/*", params);
             if (wildcardResult.has_value())
             {
@@ -94,12 +129,13 @@ bool Router::tryDispatch(const std::string &fullPath, Http::Request &req, Http::
                 
                 for (const auto &[key, value] : params)
                 {
-                    req.params[key] = value;
+                    req.setParam(key, value);
                 }
 
                 size_t middlewareIndex = 0;
-                
-                std::function<void()> next = [&]()
+
+                Next next;
+                auto step = [&]()
                 {
                     if (middlewareIndex < wildcardMiddlewares.size())
                     {
@@ -111,7 +147,8 @@ bool Router::tryDispatch(const std::string &fullPath, Http::Request &req, Http::
                         wildcardHandler(req, res, next);
                     }
                 };
-                
+                next = step;
+
                 next();
                 return true;
             }
@@ -121,8 +158,9 @@ bool Router::tryDispatch(const std::string &fullPath, Http::Request &req, Http::
 
         size_t handlerIndex = 0;
         size_t middlewareIndex = 0;
-        
-        std::function<void()> next = [&]()
+
+        Next next;
+        auto step = [&]()
         {
             if (middlewareIndex < middlewares.size())
             {
@@ -131,12 +169,16 @@ bool Router::tryDispatch(const std::string &fullPath, Http::Request &req, Http::
             }
             else if (handlerIndex < allHandlers.size())
             {
-                auto handler = allHandlers[handlerIndex++];
+                auto &handler = allHandlers[handlerIndex++];
                 handler(req, res, next);
             }
         };
-        
+        next = step;
+
         next();
+
+        // The captures point into params.
+        req.captures = {};
         return true;
     }
     return false;
@@ -144,57 +186,41 @@ bool Router::tryDispatch(const std::string &fullPath, Http::Request &req, Http::
 
 bool Router::dispatch(Http::Request &req, Http::Response &res, const std::string &basePath) const
 {
-    std::string fullPath = basePath + req.path;
+    std::string_view path = req.relativePath();
 
-    if (tryDispatch(fullPath, req, res))
+    if (basePath.empty())
     {
-        return true;
+        return tryDispatch(path, req, res);
     }
 
-    if (!basePath.empty() && tryDispatch(req.path, req, res))
+    std::string fullPath = basePath;
+    fullPath += path;
+
+    if (tryDispatch(fullPath, req, res))
     {
         return true;
     }
 
-    return false;
+    return tryDispatch(path, req, res);
 }
 
-void Router::Handle(Http::Request &req, Http::Response &res, std::function<void()> next)
+void Router::Handle(Http::Request &req, Http::Response &res, Next next)
 {
+    std::vector<MountTrie::Mount> matched;
+    mounts.match(req.relativePath(), matched);
+
+    const size_t baseOffset = req.pathOffset;
     size_t index = 0;
-    std::function<void()> callNext = [&]()
+    Next callNext;
+    auto step = [&]()
     {
-        if (index < handlers.size())
-        {
-            auto &handlerPair = handlers[index++];
-            const std::string &handlerPath = handlerPair.first;
-            IHandler *handler = handlerPair.second.get();
-
-            if (handlerPath == "/*" ||
-                req.path == handlerPath ||
-                (req.path.length() > handlerPath.length() &&
-                 req.path.substr(0, handlerPath.length()) == handlerPath &&
-                 req.path[handlerPath.length()] == '/'))
-            {
-                std::string originalPath = req.path;
-                
-                if (handlerPath == "/*") {
-                    req.path = "/";
-                } else {
-                    req.path = req.path.substr(handlerPath.length());
-                    if (req.path.empty())
-                        req.path = "/";
-                }
+        req.pathOffset = baseOffset;
 
-                handler->Handle(req, res, [&, originalPath]()
-                                {
-                    req.path = originalPath;
-                    callNext(); });
-            }
-            else
-            {
-                callNext();
-            }
+        if (index < matched.size())
+        {
+            const auto &mount = matched[index++];
+            req.pathOffset = mount.wildcard ? req.path.size() : baseOffset + mount.prefixLength;
+            mount.handler->Handle(req, res, callNext);
         }
         else
         {
@@ -204,6 +230,7 @@ void Router::Handle(Http::Request &req, Http::Response &res, std::function<void(
             }
         }
     };
+    callNext = step;
     callNext();
 }
 
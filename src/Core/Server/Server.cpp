@@ -1,6 +1,8 @@
 #include "Server.hpp"
 #include "ThreadSafeQueue.hpp"
 #include "Cluster.hpp"
+#include "ResponseCache.hpp"
+#include "EventLoop.hpp"
 
 #include <iostream>
 #include <cstring>
@@ -21,9 +23,96 @@
 #include <arpa/inet.h>
 #include <sys/epoll.h>
 #include <poll.h>
+#include <climits>
+#include <algorithm>
+#include <charconv>
+#include <cctype>
 
 std::atomic<bool> shutdownServer{false};
 
+namespace
+{
+    // How the head says the body is delimited. Header names are matched
+    // case-insensitively, line by line; repeated Transfer-Encoding lines form
+    // one coding list, and repeated Content-Length lines must agree.
+    struct Framing
+    {
+        bool malformed = false;
+        bool hasLength = false;
+        size_t contentLength = 0;
+        bool hasCoding = false;
+        std::string_view lastCoding;
+    };
+
+    std::string_view trim(std::string_view value)
+    {
+        size_t start = value.find_first_not_of(" \t");
+        if (start == std::string_view::npos)
+            return std::string_view();
+        size_t end = value.find_last_not_of(" \t");
+        return value.substr(start, end - start + 1);
+    }
+
+    bool iequals(std::string_view a, std::string_view b)
+    {
+        return a.size() == b.size() &&
+               std::equal(a.begin(), a.end(), b.begin(), [](char x, char y)
+                          { return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y)); });
+    }
+
+    Framing readFraming(std::string_view head)
+    {
+        Framing framing;
+
+        size_t lineStart = head.find("\r\n");
+        while (lineStart != std::string_view::npos)
+        {
+            lineStart += 2;
+            size_t lineEnd = head.find("\r\n", lineStart);
+            std::string_view line = head.substr(lineStart, lineEnd == std::string_view::npos ? std::string_view::npos : lineEnd - lineStart);
+            lineStart = lineEnd;
+
+            size_t colon = line.find(':');
+            if (colon == std::string_view::npos)
+                continue;
+
+            std::string_view name = line.substr(0, colon);
+            std::string_view value = trim(line.substr(colon + 1));
+            bool isLength = iequals(trim(name), "Content-Length");
+            bool isCoding = iequals(trim(name), "Transfer-Encoding");
+            if (!isLength && !isCoding)
+                continue;
+
+            // "Content-Length : 5" is not a Content-Length to every parser.
+            if (trim(name).size() != name.size())
+            {
+                framing.malformed = true;
+                continue;
+            }
+
+            if (isLength)
+            {
+                size_t length = 0;
+                auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), length);
+                if (value.empty() || ec != std::errc() || end != value.data() + value.size() ||
+                    (framing.hasLength && length != framing.contentLength))
+                {
+                    framing.malformed = true;
+                }
+                framing.hasLength = true;
+                framing.contentLength = length;
+                continue;
+            }
+
+            framing.hasCoding = true;
+            size_t comma = value.rfind(',');
+            framing.lastCoding = trim(comma == std::string_view::npos ? value : value.substr(comma + 1));
+        }
+
+        return framing;
+    }
+}
+
 void signalHandler(int signum)
 {
     shutdownServer.store(true);
@@ -243,6 +332,8 @@ void Server::handleClient(int clientSocket)
     try
     {
         const size_t BUFFER_SIZE = config.getInt("buffer_size");
+        const size_t SPILL_SIZE = config.getInt("request_spill_size", 1024 * 1024);
+        const size_t MAX_CHUNK_SIZE = config.getInt("request_max_chunk_size", 16 * 1024 * 1024);
         std::vector<char> buffer(BUFFER_SIZE);
         std::string requestData;
         requestData.reserve(BUFFER_SIZE * 2);
@@ -280,25 +371,73 @@ void Server::handleClient(int clientSocket)
             if (headerEnd == std::string::npos)
                 continue;
 
-            size_t contentLength = 0;
-            if (auto clPos = requestData.find("Content-Length:"); clPos != std::string::npos)
+            std::string_view head = std::string_view(requestData).substr(0, headerEnd);
+
+            Framing framing = readFraming(head);
+            if (framing.malformed)
             {
-                try
+                rejectRequest(clientSocket, "400 Bad Request");
+                break;
+            }
+
+            size_t contentLength = framing.contentLength;
+            bool chunked = false;
+            if (framing.hasCoding)
+            {
+                chunked = iequals(framing.lastCoding, "chunked");
+
+                // A Content-Length alongside could frame the request
+                // differently for a proxy in front of us.
+                if (!chunked || framing.hasLength)
                 {
-                    size_t clEnd = requestData.find("\r\n", clPos);
-                    std::string clStr = requestData.substr(clPos + 15, clEnd - clPos - 15);
-                    contentLength = std::stoul(clStr);
+                    rejectRequest(clientSocket, chunked ? "400 Bad Request" : "501 Not Implemented");
+                    break;
                 }
-                catch (...)
+            }
+
+            // Streaming routes get the body from the connection as they read
+            // it; bodies past SPILL_SIZE go to disk as they arrive. Neither
+            // piles up in requestData. A detached body has been taken out of
+            // requestData, which keeps just the head and what follows.
+            Http::ChunkedDecoder decoder(MAX_CHUNK_SIZE);
+            Http::File body;
+            std::unique_ptr<Http::BodyStream> stream;
+            bool detached = true;
+            if ((chunked || contentLength > 0) && routesToStream(head))
+            {
+                size_t bodyStart = headerEnd + 4;
+                if (chunked)
+                    stream = std::make_unique<Http::BodyStream>(clientSocket, decoder, BUFFER_SIZE);
+                else
+                    stream = std::make_unique<Http::BodyStream>(clientSocket, contentLength, BUFFER_SIZE);
+                requestData.erase(bodyStart, stream->prime(std::string_view(requestData).substr(bodyStart)));
+            }
+            else if (chunked)
+            {
+                if (!readChunkedBody(clientSocket, requestData, headerEnd + 4, decoder, buffer, SPILL_SIZE, body))
                 {
-                    throw std::runtime_error("Invalid Content-Length");
+                    if (decoder.failed())
+                    {
+                        bool tooLarge = decoder.error() != Http::ChunkedDecoder::Error::Malformed;
+                        rejectRequest(clientSocket, tooLarge ? "413 Payload Too Large" : "400 Bad Request");
+                    }
+                    break;
                 }
             }
-
-            if (requestData.size() < (headerEnd + 4 + contentLength))
+            else if (SPILL_SIZE && contentLength > SPILL_SIZE)
+            {
+                body = spillBody(clientSocket, requestData, headerEnd + 4, contentLength, buffer);
+                if (body.size() != contentLength)
+                    break;
+            }
+            else if (requestData.size() < (headerEnd + 4 + contentLength))
             {
                 continue;
             }
+            else
+            {
+                detached = false;
+            }
 
             char ip[INET_ADDRSTRLEN];
             char ipv6[INET6_ADDRSTRLEN];
@@ -321,102 +460,385 @@ void Server::handleClient(int clientSocket)
                 }
             }
 
-            Http::Request req;
-            if (!req.parse(requestData))
+            size_t requestEnd = headerEnd + 4 + (detached ? 0 : contentLength);
+
+            // One exchange per thread, cleared between requests; a parked
+            // connection takes it along and the thread makes a new one.
+            static thread_local std::shared_ptr<Exchange> reusable;
+            if (reusable)
+            {
+                reusable->reset();
+            }
+            else
             {
-                std::string badReq = "HTTP/1.1 400 Bad Request\r\n"
-                                     "Connection: close\r\n"
-                                     "Content-Length: 0\r\n\r\n";
-                send(clientSocket, badReq.data(), badReq.size(), MSG_NOSIGNAL);
+                reusable = std::make_shared<Exchange>();
+                reusable->res.viewDir = keys["views"];
+            }
+
+            std::shared_ptr<Exchange> exchange = reusable;
+            Http::Request &req = exchange->req;
+            std::string_view rawRequest = std::string_view(requestData).substr(0, requestEnd);
+            if (!(detached ? req.parse(rawRequest, std::move(body)) : req.parse(rawRequest)))
+            {
+                rejectRequest(clientSocket, "400 Bad Request");
                 break;
             }
 
+            req.bodyStream = std::move(stream);
+            if (!req.isStreaming() && !decoder.trailers().empty())
+                req.trailers = decoder.trailers();
             req.ip = ip;
             req.ipv6 = ipv6;
 
-            Http::Response res;
+            Http::Response &res = exchange->res;
             res._engine = _engine;
-            res.viewDir = keys["views"];
 
-            if (req.headers.find("Cookie") != req.headers.end())
+            if (req.version == "HTTP/1.1")
             {
-                std::string cookieHeader = req.headers["Cookie"];
-                size_t pos = 0;
-                while (pos < cookieHeader.length())
+                res.transport = [clientSocket](std::vector<iovec> &iov)
                 {
-                    pos = cookieHeader.find_first_not_of(" ;\t", pos);
-                    if (pos == std::string::npos)
-                        break;
+                    return sendAll(clientSocket, iov);
+                };
+            }
+            res.connection = clientSocket;
 
-                    size_t eq_pos = cookieHeader.find('=', pos);
-                    if (eq_pos == std::string::npos || eq_pos <= pos)
-                    {
-                        break;
-                    }
+            std::string_view cookieHeader = req.getHeader("Cookie");
+            size_t pos = 0;
+            while (pos < cookieHeader.length())
+            {
+                pos = cookieHeader.find_first_not_of(" ;\t", pos);
+                if (pos == std::string_view::npos)
+                    break;
 
-                    size_t end_pos = cookieHeader.find(';', eq_pos);
-                    if (end_pos == std::string::npos)
-                    {
-                        end_pos = cookieHeader.length();
-                    }
+                size_t eq_pos = cookieHeader.find('=', pos);
+                if (eq_pos == std::string_view::npos || eq_pos <= pos)
+                {
+                    break;
+                }
 
-                    std::string name = cookieHeader.substr(pos, eq_pos - pos);
-                    std::string value = cookieHeader.substr(eq_pos + 1, end_pos - eq_pos - 1);
+                size_t end_pos = cookieHeader.find(';', eq_pos);
+                if (end_pos == std::string_view::npos)
+                {
+                    end_pos = cookieHeader.length();
+                }
 
-                    auto trim = [](std::string &s)
-                    {
-                        size_t start = s.find_first_not_of(" \t");
-                        if (start == std::string::npos)
-                            return;
-                        size_t end = s.find_last_not_of(" \t");
-                        s = s.substr(start, end - start + 1);
-                    };
+                auto trim = [](std::string_view s)
+                {
+                    size_t start = s.find_first_not_of(" \t");
+                    if (start == std::string_view::npos)
+                        return s;
+                    size_t end = s.find_last_not_of(" \t");
+                    return s.substr(start, end - start + 1);
+                };
 
-                    trim(name);
-                    trim(value);
+                std::string_view name = trim(cookieHeader.substr(pos, eq_pos - pos));
+                std::string_view value = trim(cookieHeader.substr(eq_pos + 1, end_pos - eq_pos - 1));
 
-                    res.incomingCookies[name] = value;
+                res.incomingCookies.insert_or_assign(std::pmr::string(name, res.incomingCookies.get_allocator()), value);
 
-                    pos = end_pos + 1;
-                }
+                pos = end_pos + 1;
             }
 
-            this->Handle(req, res, []() {});
+            this->Handle(req, res, Next());
+
+            std::string_view connection = req.getHeader("Connection");
+            bool keepAlive = connection == "keep-alive" ||
+                             (req.version == "HTTP/1.1" && connection != "close");
 
-            std::string response = res.toString();
-            if (send(clientSocket, response.data(), response.size(), MSG_NOSIGNAL) < 0)
+            if (res.pending)
             {
-                throw std::system_error(errno, std::system_category(), "send failed");
+                // Pipelined bytes would be lost once the thread lets go of the
+                // connection, so those requests wait for the handler in place.
+                if (parkSuspended && requestData.size() == requestEnd &&
+                    park(clientSocket, exchange, keepAlive))
+                {
+                    reusable.reset();
+                    return;
+                }
+                res.pending->wait();
+                res.pending->rethrow();
             }
 
-            bool keepAlive = req.headers["Connection"] == "keep-alive" ||
-                             (req.version == "HTTP/1.1" && req.headers["Connection"] != "close");
+            sendResponse(clientSocket, *exchange);
 
-            if (!keepAlive)
+            if (!keepAlive || !exchange->drained())
                 break;
 
-            size_t requestEnd = headerEnd + 4 + contentLength;
-            if (requestData.size() > requestEnd)
+            requestData.erase(0, requestEnd);
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Client error: " << e.what() << std::endl;
+    }
+
+    close(clientSocket);
+    activeConnections--;
+}
+
+bool Server::routesToStream(std::string_view head) const
+{
+    size_t methodEnd = head.find(' ');
+    if (methodEnd == std::string_view::npos)
+        return false;
+
+    size_t pathStart = methodEnd + 1;
+    size_t pathEnd = head.find_first_of(" ?\r", pathStart);
+    if (pathEnd == std::string_view::npos)
+        return false;
+
+    return streamsBody(std::string(head.substr(0, methodEnd)), head.substr(pathStart, pathEnd - pathStart));
+}
+
+void Server::rejectRequest(int clientSocket, std::string_view status)
+{
+    std::string response = "HTTP/1.1 ";
+    response += status;
+    response += "\r\nConnection: close\r\nContent-Length: 0\r\n\r\n";
+    send(clientSocket, response.data(), response.size(), MSG_NOSIGNAL);
+}
+
+ssize_t Server::receiveBody(int clientSocket, std::vector<char> &buffer)
+{
+    while (true)
+    {
+        ssize_t valread = recv(clientSocket, buffer.data(), buffer.size(), 0);
+        if (valread >= 0)
+            return valread;
+        if (errno == EINTR)
+            continue;
+        if (errno != EAGAIN && errno != EWOULDBLOCK)
+            return -1;
+
+        struct pollfd pfd = {clientSocket, POLLIN, 0};
+        if (poll(&pfd, 1, 5000) <= 0)
+            return -1;
+    }
+}
+
+Http::File Server::spillBody(int clientSocket, std::string &requestData, size_t bodyStart, size_t contentLength, std::vector<char> &buffer)
+{
+    auto spill = Http::SpillFile::Create();
+    if (!spill)
+        return {};
+
+    size_t buffered = std::min(requestData.size() - bodyStart, contentLength);
+    if (!spill->append(requestData.data() + bodyStart, buffered))
+        return {};
+    requestData.erase(bodyStart, buffered);
+
+    while (spill->size() < contentLength)
+    {
+        ssize_t valread = receiveBody(clientSocket, buffer);
+        if (valread <= 0)
+            return {};
+
+        size_t part = std::min<size_t>(valread, contentLength - spill->size());
+        if (!spill->append(buffer.data(), part))
+            return {};
+
+        // Anything past the body is the next request.
+        requestData.append(buffer.data() + part, valread - part);
+    }
+
+    if (!spill->map())
+        return {};
+    return Http::File(std::shared_ptr<const Http::SpillFile>(std::move(spill)));
+}
+
+bool Server::readChunkedBody(int clientSocket, std::string &requestData, size_t bodyStart, Http::ChunkedDecoder &decoder,
+                             std::vector<char> &buffer, size_t spillSize, Http::File &body)
+{
+    auto bytes = std::make_shared<std::vector<char>>();
+    std::shared_ptr<Http::SpillFile> spill;
+    bool stored = true;
+
+    // Decodes input until it runs out or the body ends, appending the chunk
+    // data to bytes, or to a spill file once it outgrows spillSize. Returns
+    // how much of input was used.
+    auto feed = [&](std::string_view input)
+    {
+        size_t used = 0;
+        while (stored && used < input.size() && !decoder.done() && !decoder.failed())
+        {
+            std::string_view data;
+            used += decoder.decode(input.substr(used), data);
+            if (data.empty())
+                continue;
+
+            if (!spill && spillSize && bytes->size() + data.size() > spillSize)
             {
-                requestData = requestData.substr(requestEnd);
+                spill = Http::SpillFile::Create();
+                stored = spill && spill->append(bytes->data(), bytes->size());
+                bytes->clear();
             }
+
+            if (spill)
+                stored = stored && spill->append(data.data(), data.size());
             else
+                bytes->insert(bytes->end(), data.begin(), data.end());
+        }
+        return used;
+    };
+
+    requestData.erase(bodyStart, feed(std::string_view(requestData).substr(bodyStart)));
+
+    while (stored && !decoder.done() && !decoder.failed())
+    {
+        ssize_t valread = receiveBody(clientSocket, buffer);
+        if (valread <= 0)
+            return false;
+
+        size_t used = feed(std::string_view(buffer.data(), valread));
+
+        // Anything past the body is the next request.
+        requestData.append(buffer.data() + used, valread - used);
+    }
+
+    if (!stored || decoder.failed())
+        return false;
+
+    if (spill)
+    {
+        if (!spill->map())
+            return false;
+        body = Http::File(std::shared_ptr<const Http::SpillFile>(std::move(spill)));
+    }
+    else
+    {
+        body = Http::File(bytes, bytes->data(), bytes->size());
+    }
+    return true;
+}
+
+bool Server::sendAll(int clientSocket, std::vector<iovec> &iov)
+{
+    size_t next = 0;
+    while (next < iov.size())
+    {
+        struct msghdr msg = {};
+        msg.msg_iov = iov.data() + next;
+        msg.msg_iovlen = std::min<size_t>(iov.size() - next, IOV_MAX);
+
+        ssize_t sent = sendmsg(clientSocket, &msg, MSG_NOSIGNAL);
+        if (sent < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
             {
-                requestData.clear();
+                struct pollfd pfd = {clientSocket, POLLOUT, 0};
+                if (poll(&pfd, 1, 5000) <= 0)
+                    return false;
+                continue;
             }
+            return false;
+        }
+
+        while (next < iov.size() && static_cast<size_t>(sent) >= iov[next].iov_len)
+        {
+            sent -= iov[next].iov_len;
+            next++;
+        }
+        if (next < iov.size())
+        {
+            iov[next].iov_base = static_cast<char *>(iov[next].iov_base) + sent;
+            iov[next].iov_len -= sent;
         }
     }
+    return true;
+}
+
+void Server::gatherResponse(Exchange &exchange)
+{
+    Http::Response &res = exchange.res;
+    std::vector<iovec> &iov = exchange.iov;
+    iov.clear();
+
+    if (res.serialized)
+    {
+        iov.push_back({const_cast<char *>(res.serialized->data()), res.serialized->size()});
+        return;
+    }
+
+    exchange.head.clear();
+    res.writeHead(exchange.head);
+    iov.push_back({exchange.head.data(), exchange.head.size()});
+    if (!res.body.empty())
+        iov.push_back({res.body.data(), res.body.size()});
+    res.output.gather(iov);
+}
+
+void Server::sendResponse(int clientSocket, Exchange &exchange)
+{
+    Http::Response &res = exchange.res;
+    bool sent;
+
+    if (res.streaming)
+    {
+        sent = res.end();
+    }
+    else
+    {
+        gatherResponse(exchange);
+        sent = sendAll(clientSocket, exchange.iov);
+    }
+
+    if (!sent)
+    {
+        throw std::system_error(errno, std::system_category(), "send failed");
+    }
+}
+
+bool Server::park(int clientSocket, std::shared_ptr<Exchange> exchange, bool keepAlive)
+{
+    Nerva::Completion &completion = *exchange->res.pending;
+    return completion.then([this, clientSocket, exchange, keepAlive]()
+                           { finishParked(clientSocket, exchange, keepAlive); });
+}
+
+// Runs on whichever thread finished the handler, usually the event loop's, so
+// the response is queued and drained through the loop rather than sent with
+// sendAll, which would hold up every other parked connection.
+Nerva::Detached Server::finishParked(int clientSocket, std::shared_ptr<Exchange> exchange, bool keepAlive)
+{
+    Http::Response &res = exchange->res;
+    bool reuse = keepAlive;
+    try
+    {
+        res.pending->rethrow();
+        if (res.streaming)
+        {
+            res.queueEnd();
+        }
+        else
+        {
+            gatherResponse(*exchange);
+            res.queue(exchange->iov);
+        }
+        co_await res.drain();
+        reuse = reuse && exchange->drained();
+    }
     catch (const std::exception &e)
     {
         std::cerr << "Client error: " << e.what() << std::endl;
+        reuse = false;
     }
 
-    close(clientSocket);
     activeConnections--;
+    if (reuse && !shutdownServer)
+        socketQueue.push(clientSocket);
+    else
+        close(clientSocket);
 }
 
 void Server::Start()
 {
+    Http::ResponseCache::Shared().setCapacity(config.getInt("response_cache_size", 64 * 1024 * 1024));
+    Nerva::OffloadPool::Shared().configure(config.getInt("offload_threads", 4), config.getInt("offload_queue_size", 256));
+
+    WarmUp();
+
     bool singleThreaded = config.getBool("single_threaded");
     
     if (singleThreaded)
@@ -463,8 +885,39 @@ void Server::Start()
     }
 }
 
+// Runs before fork so every worker starts with compiled views, the asset
+// manifest and preloaded static files, shared with the master until one of
+// them writes to a page.
+void Server::WarmUp()
+{
+    if (config.getBool("asset_fingerprints", true))
+    {
+        size_t assets = 0;
+        for (auto &[path, handler] : staticHandlers)
+            assets += handler->Fingerprint(path);
+        std::cout << "Fingerprinted " << assets << " static files\n";
+    }
+
+    if (_engine && config.getBool("warm_up_views", true))
+    {
+        size_t views = _engine->warmUp();
+        std::cout << "Warmed up " << views << " views\n";
+    }
+
+    size_t budget = config.getInt("static_preload_size", 0);
+    if (budget == 0)
+        return;
+
+    size_t loaded = 0;
+    for (auto &[path, handler] : staticHandlers)
+        loaded += handler->Preload(budget - loaded);
+    std::cout << "Preloaded " << loaded << " bytes of static files\n";
+}
+
 void Server::StartWorker()
 {
+    parkSuspended = true;
+
     for (int i = 0; i < 4; ++i)
     {
         acceptThreads.emplace_back(&Server::acceptConnections, this);
@@ -609,6 +1062,9 @@ void Server::Stop()
     shutdownServer.store(true);
     std::this_thread::sleep_for(std::chrono::milliseconds(100));
 
+    Nerva::OffloadPool::Shared().Stop();
+    Nerva::EventLoop::Instance().Stop();
+
     for (auto &t : acceptThreads)
     {
         if (t.joinable())
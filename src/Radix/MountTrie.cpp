@@ -0,0 +1,107 @@
+#include "MountTrie.hpp"
+
+#include <algorithm>
+
+MountTrie::MountTrie() = default;
+MountTrie::~MountTrie() = default;
+
+void MountTrie::insert(const std::string &path, size_t order, IHandler *handler)
+{
+    if (path == "/*")
+    {
+        wildcardMounts.push_back({order, 0, true, handler});
+        return;
+    }
+
+    Node *current = &root;
+    size_t pos = 0;
+
+    while (pos < path.size())
+    {
+        std::string_view rest(path.data() + pos, path.size() - pos);
+
+        auto it = std::find_if(current->children.begin(), current->children.end(),
+                               [&](const std::unique_ptr<Node> &child)
+                               { return child->edge[0] == rest[0]; });
+
+        if (it == current->children.end())
+        {
+            auto child = std::make_unique<Node>();
+            child->edge = std::string(rest);
+            current->children.push_back(std::move(child));
+            current = current->children.back().get();
+            pos = path.size();
+            break;
+        }
+
+        Node *child = it->get();
+        size_t common = commonPrefix(child->edge, rest);
+
+        if (common < child->edge.size())
+        {
+            auto split = std::make_unique<Node>();
+            split->edge = child->edge.substr(0, common);
+            (*it)->edge.erase(0, common);
+            split->children.push_back(std::move(*it));
+            *it = std::move(split);
+            child = it->get();
+        }
+
+        current = child;
+        pos += common;
+    }
+
+    current->mounts.push_back({order, path.size(), false, handler});
+}
+
+void MountTrie::match(std::string_view path, std::vector<Mount> &matches) const
+{
+    const Node *current = &root;
+    size_t depth = 0;
+
+    while (true)
+    {
+        if (!current->mounts.empty() && (depth == path.size() || path[depth] == '/'))
+        {
+            matches.insert(matches.end(), current->mounts.begin(), current->mounts.end());
+        }
+
+        if (depth >= path.size())
+            break;
+
+        const Node *next = nullptr;
+        for (const auto &child : current->children)
+        {
+            if (child->edge[0] == path[depth] &&
+                path.compare(depth, child->edge.size(), child->edge) == 0)
+            {
+                next = child.get();
+                break;
+            }
+        }
+
+        if (!next)
+            break;
+
+        depth += next->edge.size();
+        current = next;
+    }
+
+    if (!wildcardMounts.empty())
+    {
+        matches.insert(matches.end(), wildcardMounts.begin(), wildcardMounts.end());
+    }
+
+    std::sort(matches.begin(), matches.end(),
+              [](const Mount &a, const Mount &b)
+              { return a.order < b.order; });
+}
+
+size_t MountTrie::commonPrefix(std::string_view a, std::string_view b)
+{
+    size_t n = std::min(a.size(), b.size());
+    size_t i = 0;
+    while (i < n && a[i] == b[i])
+        ++i;
+    return i;
+}
@@ -13,7 +13,8 @@ RadixNode::~RadixNode() = default;
 void RadixNode::insert(const std::vector<std::reference_wrapper<IHandler>> &middlewares,
                        const std::string &method,
                        const std::string &path,
-                       const RequestHandler &handler)
+                       const RequestHandler &handler,
+                       bool typed)
 {
     auto segments = split(path);
 
@@ -24,20 +25,22 @@ void RadixNode::insert(const std::vector<std::reference_wrapper<IHandler>> &midd
         RadixNode *child = current->findChild(seg);
         if (!child)
         {
-            current->children.push_back(std::make_unique<RadixNode>(seg));
+            current->children.push_back(std::make_unique<RadixNode>(std::string(seg)));
             child = current->children.back().get();
         }
         current = child;
     }
 
-    current->methodHandlers[method].push_back(handler);
+    auto &handlers = current->methodHandlers[method];
+    current->methodTyped[method] = typed && (handlers.empty() || current->methodTyped[method]);
+    handlers.push_back(handler);
     if (!middlewares.empty())
     {
         current->methodMiddlewares[method] = middlewares;
     }
 }
 
-std::optional<std::pair<RequestHandler, std::vector<std::reference_wrapper<IHandler>>>> RadixNode::find(const std::string &method, const std::string &path, std::map<std::string, std::string> &params) const
+std::optional<std::pair<RequestHandler, std::vector<std::reference_wrapper<IHandler>>>> RadixNode::find(const std::string &method, std::string_view path, Params &params, bool *typed) const
 {
     auto segments = split(path);
 
@@ -61,6 +64,8 @@ std::optional<std::pair<RequestHandler, std::vector<std::reference_wrapper<IHand
                     {
                         middlewares = mwIt->second;
                     }
+                    if (typed)
+                        *typed = next->isTyped(method);
                     return std::make_pair(handlerIt->second[0], middlewares);
                 }
             }
@@ -69,8 +74,7 @@ std::optional<std::pair<RequestHandler, std::vector<std::reference_wrapper<IHand
             if (!next)
                 return std::nullopt;
 
-            std::string paramName = next->segment.substr(1);
-            params[paramName] = seg;
+            params.emplace_back(std::string_view(next->segment).substr(1), seg);
             exactMatch = false;
         }
         current = next;
@@ -85,6 +89,8 @@ std::optional<std::pair<RequestHandler, std::vector<std::reference_wrapper<IHand
         {
             middlewares = mwIt->second;
         }
+        if (typed)
+            *typed = current->isTyped(method);
 
         return std::make_pair(handlerIt->second[0], middlewares);
     }
@@ -92,7 +98,7 @@ std::optional<std::pair<RequestHandler, std::vector<std::reference_wrapper<IHand
     return std::nullopt;
 }
 
-std::vector<RequestHandler> RadixNode::getAllHandlers(const std::string &method, const std::string &path) const
+std::vector<RequestHandler> RadixNode::getAllHandlers(const std::string &method, std::string_view path) const
 {
     auto segments = split(path);
     const RadixNode *current = this;
@@ -130,6 +136,12 @@ std::vector<RequestHandler> RadixNode::getAllHandlers(const std::string &method,
     return {};
 }
 
+bool RadixNode::isTyped(const std::string &method) const
+{
+    auto it = methodTyped.find(method);
+    return it != methodTyped.end() && it->second;
+}
+
 bool RadixNode::isParam() const
 {
     return !segment.empty() && segment[0] == ':';
@@ -140,7 +152,7 @@ bool RadixNode::isWildcard() const
     return segment == "*";
 }
 
-RadixNode *RadixNode::findChild(const std::string &seg) const
+RadixNode *RadixNode::findChild(std::string_view seg) const
 {
     for (const auto &child : children)
     {
@@ -174,18 +186,22 @@ RadixNode *RadixNode::findWildcardChild() const
     return nullptr;
 }
 
-std::vector<std::string> RadixNode::split(const std::string &path)
+std::vector<std::string_view> RadixNode::split(std::string_view path)
 {
-    std::vector<std::string> segments;
-    std::stringstream ss(path);
-    std::string item;
+    std::vector<std::string_view> segments;
+    size_t start = 0;
 
-    while (std::getline(ss, item, '/'))
+    while (start < path.size())
     {
-        if (!item.empty())
+        size_t end = path.find('/', start);
+        if (end == std::string_view::npos)
+            end = path.size();
+
+        if (end > start)
         {
-            segments.push_back(item);
+            segments.push_back(path.substr(start, end - start));
         }
+        start = end + 1;
     }
 
     return segments;
@@ -1,12 +1,30 @@
 #include "Engine.hpp"
 #include "Response.hpp"
+#include "ViewRuntime.hpp"
+#include "EventLoop.hpp"
 
 #include <fstream>
 #include <sstream>
 #include <stdexcept>
+#include <iostream>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/inotify.h>
 
 namespace Nerva
 {
+    Engine::Engine()
+    {
+        bindCompiledFilters();
+    }
+
+    Engine::~Engine()
+    {
+        stopWatching = true;
+        if (watcher && watcherPid == getpid() && watcher->joinable())
+            watcher->join();
+    }
+
     void Engine::setViewsDirectory(const std::string &path)
     {
         viewsDir = std::filesystem::path(path);
@@ -17,304 +35,419 @@ namespace Nerva
         }
     }
 
-    void Engine::render(Http::Response &res, const std::string &templateName, const json &context)
+    void Engine::setHotReload(bool enabled)
     {
-        std::string templateContent = loadTemplate(templateName);
+        hotReload = enabled;
+    }
 
-        res.setHeader("Content-Type", "text/html; charset=UTF-8");
-        res.body = renderString(templateContent, context);
+    void Engine::setStreamThreshold(size_t bytes)
+    {
+        streamThreshold = bytes;
     }
 
-    std::string Engine::loadTemplate(const std::string &templateName)
+    void Engine::setFragmentCacheSize(size_t bytes)
     {
-        auto it = templateCache.find(templateName);
-        if (it != templateCache.end())
-        {
-            return it->second;
-        }
+        fragments.setCapacity(bytes);
+    }
 
-        std::filesystem::path templatePath = viewsDir / (templateName + ".html");
-        std::ifstream file(templatePath);
-        if (!file.is_open())
+    void Engine::RegisterFilter(const std::string &name, FilterFunction function)
+    {
+        // Renders read filters and compiledFilters without a lock.
+        if (sealed.load(std::memory_order_relaxed))
+            throw std::logic_error("Filter '" + name + "' registered after views were warmed up or rendered");
+
+        filters.add(name, function);
+        templates.clear();
+        bindCompiledFilters();
+    }
+
+    void Engine::bindCompiledFilters()
+    {
+        compiledFilters.clear();
+        unboundFilter.clear();
+        if (const View::Registry *compiled = View::Registered())
         {
-            throw std::runtime_error("Could not open template file: " + templatePath.string());
+            for (const std::string &name : compiled->filters)
+            {
+                compiledFilters.push_back(filters.find(name));
+                if (!compiledFilters.back() && unboundFilter.empty())
+                    unboundFilter = name;
+            }
         }
+    }
 
-        std::stringstream buffer;
-        buffer << file.rdbuf();
-        std::string content = buffer.str();
-
-        templateCache[templateName] = content;
-        return content;
+    void Engine::checkCompiledFilters() const
+    {
+        if (!unboundFilter.empty())
+            throw std::runtime_error("Compiled views use unknown filter '" + unboundFilter + "'");
     }
 
-    std::string Engine::renderString(const std::string &content, const json &context)
+    void Engine::render(Http::Response &res, const std::string &templateName, const Value &context)
     {
-        std::string result;
-        size_t pos = 0;
-        size_t start_pos, end_pos;
+        if (!sealed.load(std::memory_order_relaxed))
+            sealed.store(true, std::memory_order_relaxed);
+
+        if (hotReload)
+            ensureWatcher();
+
+        View::Render view = nullptr;
+        std::shared_ptr<const CompiledTemplate> compiled;
+
+        const View::Registry *registered = hotReload ? nullptr : View::Registered();
+        auto it = registered ? registered->views.find(templateName) : decltype(registered->views.end())();
+        if (registered && it != registered->views.end())
+            view = it->second;
+        else
+            compiled = loadTemplate(templateName);
 
-        while ((start_pos = content.find("{{", pos)) != std::string::npos)
+        res.setHeader("Content-Type", "text/html; charset=UTF-8");
+        res.body.clear();
+        res.output.clear();
+
+        // flush() blocks on a slow reader, which the event loop thread must
+        // not do, so a render resumed there is sent whole once it finishes.
+        Output out{res.output};
+        if (streamThreshold && res.transport && !EventLoop::InLoop())
         {
-            result += content.substr(pos, start_pos - pos);
+            out.stream = &res;
+            out.flushAt = streamThreshold;
+        }
 
-            end_pos = content.find("}}", start_pos);
-            if (end_pos == std::string::npos)
-                break;
+        if (view)
+        {
+            checkCompiledFilters();
+            view(*this, Scope{nullptr, context, {}, {}}, out, compiledFilters.data());
+            return;
+        }
 
-            std::string expr = content.substr(start_pos + 2, end_pos - start_pos - 2);
-            expr.erase(0, expr.find_first_not_of(" \t\n\r"));
-            expr.erase(expr.find_last_not_of(" \t\n\r") + 1);
+        res.output.retain(compiled);
+        execute(compiled->nodes(), Scope{nullptr, context, {}, {}}, out);
+    }
 
-            if (expr.rfind("for", 0) == 0)
-            {
-                size_t loopEnd = content.find("{{ endfor }}", end_pos);
-                if (loopEnd == std::string::npos)
-                {
-                    pos = end_pos + 2;
-                    continue;
-                }
+    size_t Engine::warmUp()
+    {
+        sealed.store(true, std::memory_order_relaxed);
+        const View::Registry *registered = hotReload ? nullptr : View::Registered();
+        size_t count = 0;
+        std::error_code ec;
 
-                std::string loopContent = content.substr(end_pos + 2, loopEnd - (end_pos + 2));
-                std::string loopResult = processForLoop(expr, loopContent, context);
-                result += loopResult;
+        if (registered && !unboundFilter.empty())
+            std::cerr << "Template warm-up failed: compiled views use unknown filter '" << unboundFilter << "'" << std::endl;
 
-                pos = loopEnd + strlen("{{ endfor }}");
-            }
-            else if (expr.rfind("if", 0) == 0)
-            {
-                size_t ifEnd = content.find("{{ endif }}", end_pos);
-                if (ifEnd == std::string::npos)
-                {
-                    pos = end_pos + 2;
-                    continue;
-                }
+        for (auto it = std::filesystem::directory_iterator(viewsDir, ec); !ec && it != std::filesystem::directory_iterator(); it.increment(ec))
+        {
+            if (!it->is_regular_file() || it->path().extension() != ".html")
+                continue;
 
-                std::string ifContent = content.substr(end_pos + 2, ifEnd - (end_pos + 2));
-                std::string ifResult = processIfCondition(expr, ifContent, context);
-                result += ifResult;
+            std::string name = it->path().stem().string();
+            if (registered && registered->views.count(name))
+                continue;
 
-                pos = ifEnd + strlen("{{ endif }}");
-            }
-            else if (expr.rfind("include", 0) == 0)
+            try
             {
-                size_t withPos = expr.find(" with ");
-                if (withPos != std::string::npos)
-                {
-                    std::string templateName = expr.substr(8, withPos - 8);
-                    std::string contextVar = expr.substr(withPos + 6);
-
-                    json includeContext = resolvePath(contextVar, context);
-                    if (!includeContext.is_null())
-                    {
-                        json newContext = context;
-                        newContext["it"] = includeContext;
-
-                        std::string included = loadTemplate(templateName);
-                        result += renderString(included, newContext);
-                    }
-                }
-                else
-                {
-                    result += evaluateExpression(expr, context);
-                }
-                pos = end_pos + 2;
+                loadTemplate(name);
+                ++count;
             }
-            else
+            catch (const std::exception &e)
             {
-                result += evaluateExpression(expr, context);
-                pos = end_pos + 2;
+                std::cerr << "Template warm-up failed: " << e.what() << std::endl;
             }
         }
 
-        result += content.substr(pos);
-        return result;
+        return count;
     }
 
-    std::string Engine::processForLoop(const std::string &loopExpr,
-                                       const std::string &loopContent,
-                                       const json &context)
+    void Engine::include(const std::string &templateName, const Scope &scope, Output &out)
     {
-        size_t inPos = loopExpr.find(" in ");
-        if (inPos == std::string::npos)
-            return "";
-
-        std::string varsPart = loopExpr.substr(3, inPos - 3);
-        std::string collectionName = loopExpr.substr(inPos + 4);
-
-        varsPart.erase(0, varsPart.find_first_not_of(" \t"));
-        varsPart.erase(varsPart.find_last_not_of(" \t") + 1);
-        collectionName.erase(0, collectionName.find_first_not_of(" \t"));
-        collectionName.erase(collectionName.find_last_not_of(" \t") + 1);
+        if (const View::Registry *registered = hotReload ? nullptr : View::Registered())
+        {
+            auto it = registered->views.find(templateName);
+            if (it != registered->views.end())
+            {
+                checkCompiledFilters();
+                it->second(*this, scope, out, compiledFilters.data());
+                return;
+            }
+        }
 
-        json collection = resolvePath(collectionName, context);
-        if (!collection.is_array())
-            return "";
+        auto included = loadTemplate(templateName);
+        out.buffer.retain(included);
+        execute(included->nodes(), scope, out);
+    }
 
-        std::string result;
-        bool hasIndex = varsPart.find(',') != std::string::npos;
-        std::string itemVar, indexVar;
+    Http::ResponseCache::Bytes Engine::findFragment(const std::string &key)
+    {
+        return fragments.lookup(key, Http::ResponseCache::Clock::now());
+    }
 
-        if (hasIndex)
-        {
-            size_t commaPos = varsPart.find(',');
-            itemVar = varsPart.substr(0, commaPos);
-            indexVar = varsPart.substr(commaPos + 1);
-
-            itemVar.erase(0, itemVar.find_first_not_of(" \t"));
-            itemVar.erase(itemVar.find_last_not_of(" \t") + 1);
-            indexVar.erase(0, indexVar.find_first_not_of(" \t"));
-            indexVar.erase(indexVar.find_last_not_of(" \t") + 1);
-        }
-        else
+    Http::ResponseCache::Bytes Engine::storeFragment(const std::string &key, int ttl, const Http::OutputBuffer &fragment)
+    {
+        auto bytes = std::make_shared<const std::string>(fragment.str());
+        if (ttl > 0)
         {
-            itemVar = varsPart;
+            auto expires = Http::ResponseCache::Clock::now() + std::chrono::seconds(ttl);
+            fragments.store(key, bytes, expires, expires);
         }
+        return bytes;
+    }
 
-        size_t i = 0;
-        for (auto &item : collection)
-        {
-            json newContext = context;
-            newContext[itemVar] = item;
+    void Engine::Output::flushIfFull()
+    {
+        if (buffer.size() >= flushAt && !stream->flush())
+            stream = nullptr;
+    }
 
-            if (hasIndex)
+    Value Engine::Scope::find(const std::string &key) const
+    {
+        for (const Scope *scope = this; scope; scope = scope->parent)
+        {
+            if (!scope->object.missing())
             {
-                newContext[indexVar] = i;
+                Value found = scope->object.member(key);
+                if (!found.missing())
+                    return found;
+            }
+            else if (scope->name == key)
+            {
+                return scope->value;
             }
-
-            result += renderString(loopContent, newContext);
-            i++;
         }
+        return {};
+    }
 
-        return result;
+    std::shared_ptr<const CompiledTemplate> Engine::loadTemplate(const std::string &templateName)
+    {
+        return templates.get(templateName, [this](const std::string &name)
+                             { return compileFile(name); });
     }
 
-    std::string Engine::processIfCondition(const std::string &ifExpr,
-                                           const std::string &ifContent,
-                                           const json &context)
+    std::shared_ptr<const CompiledTemplate> Engine::compileFile(const std::string &templateName)
     {
-        size_t condStart = ifExpr.find_first_not_of(" \t", 2);
-        if (condStart == std::string::npos)
-            return "";
+        std::filesystem::path templatePath = viewsDir / (templateName + ".html");
+        std::ifstream file(templatePath);
+        if (!file.is_open())
+        {
+            throw std::runtime_error("Could not open template file: " + templatePath.string());
+        }
 
-        std::string condition = ifExpr.substr(condStart);
-        json value = resolvePath(condition, context);
+        std::stringstream buffer;
+        buffer << file.rdbuf();
 
-        if (!value.is_null() &&
-            ((value.is_boolean() && value.get<bool>()) ||
-             (value.is_number() && value.get<double>() != 0) ||
-             (value.is_string() && !value.get<std::string>().empty())))
+        try
+        {
+            return std::make_shared<const CompiledTemplate>(buffer.str(), &filters);
+        }
+        catch (const std::runtime_error &e)
         {
-            return renderString(ifContent, context);
+            throw std::runtime_error(templatePath.string() + ": " + e.what());
         }
+    }
+
+    void Engine::ensureWatcher()
+    {
+        std::lock_guard<std::mutex> lock(watcherMtx);
+        if (watcherPid == getpid())
+            return;
 
-        return "";
+        // A watcher inherited across fork() has no thread behind it here.
+        if (watcher)
+            watcher.release();
+
+        watcherPid = getpid();
+        watcher = std::make_unique<std::thread>(&Engine::watchViews, this);
     }
 
-    std::string Engine::evaluateExpression(const std::string &expr, const json &context)
+    void Engine::watchViews()
     {
-        if (expr.rfind("include", 0) == 0)
+        int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (fd == -1 || inotify_add_watch(fd, viewsDir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE | IN_MOVED_FROM) == -1)
         {
-            size_t quotePos = expr.find('\'');
-            if (quotePos == std::string::npos)
-                quotePos = expr.find('"');
-            if (quotePos == std::string::npos)
-                return "";
-
-            size_t endQuotePos = expr.find(expr[quotePos], quotePos + 1);
-            if (endQuotePos == std::string::npos)
-                return "";
-
-            std::string templateName = expr.substr(quotePos + 1, endQuotePos - quotePos - 1);
-            return loadTemplate(templateName);
+            perror("inotify");
+            if (fd != -1)
+                close(fd);
+            return;
         }
-        else if (expr.find('|') != std::string::npos)
-        {
-            size_t pipePos = expr.find('|');
-            std::string varName = expr.substr(0, pipePos);
-            varName.erase(0, varName.find_first_not_of(" \t"));
-            varName.erase(varName.find_last_not_of(" \t") + 1);
 
-            std::string filter = expr.substr(pipePos + 1);
-            filter.erase(0, filter.find_first_not_of(" \t"));
-            filter.erase(filter.find_last_not_of(" \t") + 1);
+        alignas(inotify_event) char buffer[4096];
 
-            json value = resolvePath(varName, context);
-            std::string result;
+        while (!stopWatching)
+        {
+            struct pollfd pfd = {fd, POLLIN, 0};
+            if (poll(&pfd, 1, 200) <= 0)
+                continue;
 
-            if (value.is_boolean())
-            {
-                result = value.get<bool>() ? "true" : "false";
-            }
-            else if (value.is_number())
-            {
-                result = std::to_string(value.get<double>());
-            }
-            else if (value.is_string())
+            ssize_t length = read(fd, buffer, sizeof(buffer));
+            for (ssize_t offset = 0; offset < length;)
             {
-                result = value.get<std::string>();
-            }
+                auto *event = reinterpret_cast<inotify_event *>(buffer + offset);
+                offset += sizeof(inotify_event) + event->len;
 
-            if (filter == "formatPrice")
-            {
-                size_t dotPos = result.find('.');
-                if (dotPos != std::string::npos)
-                {
-                    result = result.substr(0, dotPos + 3);
-                }
-                if (result.length() > 6)
+                std::string_view file = event->len ? std::string_view(event->name) : std::string_view();
+                if (file.size() <= 5 || file.substr(file.size() - 5) != ".html")
+                    continue;
+
+                std::string name(file.substr(0, file.size() - 5));
+                if (!templates.find(name))
+                    continue;
+
+                if (event->mask & (IN_DELETE | IN_MOVED_FROM))
                 {
-                    result.insert(result.length() - 6, ".");
+                    templates.erase(name);
+                    continue;
                 }
-            }
-            else if (filter == "add:1")
-            {
+
                 try
                 {
-                    int num = std::stoi(result);
-                    result = std::to_string(num + 1);
+                    templates.put(name, compileFile(name));
                 }
-                catch (...)
+                catch (const std::exception &e)
                 {
+                    std::cerr << "Template reload failed: " << e.what() << std::endl;
+                    templates.erase(name);
                 }
             }
+        }
 
-            return result;
+        close(fd);
+    }
+
+    void Engine::execute(const std::vector<Node> &nodes, const Scope &scope, Output &out)
+    {
+        for (const Node &node : nodes)
+        {
+            switch (node.kind)
+            {
+            case Node::Kind::Text:
+                out.buffer.reference(node.text);
+                break;
+            case Node::Kind::Output:
+            {
+                json storage;
+                View::write(evaluate(node.expr, scope, storage), node.expr.raw, out.buffer);
+                break;
+            }
+            case Node::Kind::For:
+                executeFor(node, scope, out);
+                break;
+            case Node::Kind::If:
+                execute(test(node.condition, scope) ? node.body : node.elseBody, scope, out);
+                break;
+            case Node::Kind::Include:
+                executeInclude(node, scope, out);
+                break;
+            case Node::Kind::Cache:
+                executeCache(node, scope, out);
+                break;
+            }
+
+            if (out.stream)
+                out.flushIfFull();
         }
-        else
+    }
+
+    void Engine::executeFor(const Node &node, const Scope &scope, Output &out)
+    {
+        json storage;
+        Value collection = evaluate(node.expr, scope, storage);
+
+        if (collection.isArray())
         {
-            json value = resolvePath(expr, context);
-
-            if (value.is_null())
-                return "";
-            if (value.is_boolean())
-                return value.get<bool>() ? "true" : "false";
-            if (value.is_number())
-                return std::to_string(value.get<double>());
-            if (value.is_string())
-                return value.get<std::string>();
-            if (value.is_object())
-                return "[object]";
-            if (value.is_array())
-                return "[array]";
-
-            return "";
+            for (size_t index = 0, count = collection.size(); index < count; ++index)
+            {
+                Scope itemScope{&scope, {}, node.itemVar, collection.at(index)};
+                Scope indexScope{&itemScope, {}, node.indexVar, Value::of(index)};
+
+                execute(node.body, node.indexVar.empty() ? itemScope : indexScope, out);
+            }
         }
+        else if (collection.isObject())
+        {
+            collection.each([&](const Value &key, const Value &value)
+                            {
+                                Scope keyScope{&scope, {}, node.itemVar, key};
+                                Scope valueScope{&keyScope, {}, node.indexVar, value};
+
+                                execute(node.body, node.indexVar.empty() ? keyScope : valueScope, out); });
+        }
+    }
+
+    void Engine::executeInclude(const Node &node, const Scope &scope, Output &out)
+    {
+        if (!node.hasWith)
+        {
+            include(node.templateName, scope, out);
+            return;
+        }
+
+        json storage;
+        Value includeContext = evaluate(node.expr, scope, storage);
+        if (includeContext.isNull())
+            return;
+
+        include(node.templateName, Scope{&scope, {}, "it", includeContext}, out);
     }
 
-    json Engine::resolvePath(const std::string &path, const json &data)
+    void Engine::executeCache(const Node &node, const Scope &scope, Output &out)
     {
-        size_t dotPos = path.find('.');
-        if (dotPos == std::string::npos)
+        std::string key;
+        for (const Expression &part : node.cacheKey)
         {
-            return data.contains(path) ? data[path] : json();
+            json storage;
+            key += View::text(evaluate(part, scope, storage));
         }
 
-        std::string firstPart = path.substr(0, dotPos);
-        if (!data.contains(firstPart))
-            return json();
+        auto bytes = findFragment(key);
+        if (!bytes)
+        {
+            // Rendered on its own so the fragment is never split by a flush.
+            Http::OutputBuffer buffer;
+            Output fragment{buffer};
+            execute(node.body, scope, fragment);
+            bytes = storeFragment(key, node.ttl, buffer);
+        }
+
+        out.buffer.retain(bytes);
+        out.buffer.reference(*bytes);
+    }
+
+    bool Engine::test(const Condition &condition, const Scope &scope)
+    {
+        json leftStorage, rightStorage;
+        Value left = evaluate(condition.left, scope, leftStorage);
+        bool result = condition.op == Condition::Op::Truthy
+                          ? View::truthy(left)
+                          : View::compare(condition.op, left, evaluate(condition.right, scope, rightStorage));
+
+        return condition.negate ? !result : result;
+    }
+
+    Value Engine::evaluate(const Expression &expr, const Scope &scope, json &storage)
+    {
+        Value value = expr.isLiteral ? Value(expr.literal) : resolvePath(expr.path, scope, storage);
+
+        // Filters take json, so typed values are converted only here.
+        for (const Filter &filter : expr.filters)
+        {
+            storage = filter.function(value.asJson(storage), filter.arguments);
+            value = storage;
+        }
+
+        return value;
+    }
+
+    Value Engine::resolvePath(const std::vector<PathSegment> &path, const Scope &scope, json &storage)
+    {
+        if (path.empty() || path.front().isIndex)
+            return {};
+
+        Value current = scope.find(path.front().key);
+
+        for (size_t i = 1; !current.missing() && i < path.size(); ++i)
+        {
+            const PathSegment &segment = path[i];
+            current = segment.isIndex ? View::element(current, segment.index, storage) : current.member(segment.key);
+        }
 
-        std::string remainingPath = path.substr(dotPos + 1);
-        return resolvePath(remainingPath, data[firstPart]);
+        return current;
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,214 @@
+#include "Filters.hpp"
+#include "AssetManifest.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <limits>
+
+namespace Nerva
+{
+    namespace
+    {
+        // Numbers, and strings that consist of a numeric literal.
+        bool toNumber(const json &value, json &number)
+        {
+            if (value.is_number())
+            {
+                number = value;
+                return true;
+            }
+            if (!value.is_string())
+                return false;
+
+            const std::string &text = value.get_ref<const std::string &>();
+            const char *begin = text.data();
+            const char *end = begin + text.size();
+
+            long long integer;
+            auto [intEnd, intErr] = std::from_chars(begin, end, integer);
+            if (intErr == std::errc() && intEnd == end)
+            {
+                number = integer;
+                return true;
+            }
+
+            double real;
+            auto [realEnd, realErr] = std::from_chars(begin, end, real);
+            if (realErr == std::errc() && realEnd == end)
+            {
+                number = real;
+                return true;
+            }
+            return false;
+        }
+
+        long long integerArgument(const FilterArguments &arguments, size_t i, long long fallback)
+        {
+            json number;
+            if (i < arguments.size() && toNumber(arguments[i], number))
+                return number.get<long long>();
+            return fallback;
+        }
+
+        json addNumber(const json &value, const FilterArguments &arguments)
+        {
+            json left, right;
+            if (!toNumber(value, left) || arguments.empty() || !toNumber(arguments[0], right))
+                return value;
+
+            if (left.is_number_integer() && right.is_number_integer())
+                return left.get<long long>() + right.get<long long>();
+            return left.get<double>() + right.get<double>();
+        }
+
+        json round(const json &value, const FilterArguments &arguments)
+        {
+            json number;
+            if (!toNumber(value, number))
+                return value;
+
+            long long digits = integerArgument(arguments, 0, 0);
+            if (digits <= 0)
+                return static_cast<long long>(std::llround(number.get<double>()));
+
+            double scale = std::pow(10.0, static_cast<double>(digits));
+            return std::round(number.get<double>() * scale) / scale;
+        }
+
+        // Two decimals, with '.' between thousands groups: 12499.99 -> 12.499.99
+        json formatPrice(const json &value, const FilterArguments &)
+        {
+            json number;
+            double amount = toNumber(value, number) ? number.get<double>() : 0;
+            if (!std::isfinite(amount))
+                return toText(value);
+
+            // Every integer digit of the largest double, sign, '.' and two
+            // decimals.
+            char buffer[std::numeric_limits<double>::max_exponent10 + 6];
+            auto result = std::to_chars(buffer, buffer + sizeof(buffer), amount, std::chars_format::fixed, 2);
+            if (result.ec != std::errc())
+                return toText(value);
+            std::string_view digits(buffer, result.ptr - buffer);
+
+            size_t dot = digits.find('.');
+            size_t first = digits.front() == '-' ? 1 : 0;
+
+            std::string price(digits.substr(0, first));
+            for (size_t i = first; i < dot; ++i)
+            {
+                if (i > first && (dot - i) % 3 == 0)
+                    price += '.';
+                price += digits[i];
+            }
+            price += digits.substr(dot);
+            return price;
+        }
+
+        json length(const json &value, const FilterArguments &)
+        {
+            if (value.is_string())
+                return value.get_ref<const std::string &>().size();
+            if (value.is_array() || value.is_object())
+                return value.size();
+            return 0;
+        }
+
+        json asset(const json &value, const FilterArguments &)
+        {
+            return Http::AssetManifest::Shared().url(toText(value));
+        }
+
+        json uppercase(const json &value, const FilterArguments &)
+        {
+            std::string text = toText(value);
+            std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c)
+                           { return std::toupper(c); });
+            return text;
+        }
+
+        json lowercase(const json &value, const FilterArguments &)
+        {
+            std::string text = toText(value);
+            std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c)
+                           { return std::tolower(c); });
+            return text;
+        }
+
+        // truncate:N or truncate:N,"suffix"; never splits a UTF-8 sequence.
+        json truncate(const json &value, const FilterArguments &arguments)
+        {
+            std::string text = toText(value);
+            long long limit = integerArgument(arguments, 0, 0);
+            if (limit < 0 || text.size() <= static_cast<size_t>(limit))
+                return text;
+
+            size_t cut = static_cast<size_t>(limit);
+            while (cut > 0 && (static_cast<unsigned char>(text[cut]) & 0xC0) == 0x80)
+                --cut;
+
+            text.resize(cut);
+            text += arguments.size() > 1 ? toText(arguments[1]) : "...";
+            return text;
+        }
+
+        json fallback(const json &value, const FilterArguments &arguments)
+        {
+            bool missing = value.is_null() || (value.is_string() && value.get_ref<const std::string &>().empty());
+            return missing && !arguments.empty() ? arguments[0] : value;
+        }
+    }
+
+    FilterRegistry::FilterRegistry()
+    {
+        functions = {
+            {"add", addNumber},
+            {"asset", asset},
+            {"default", fallback},
+            {"formatPrice", formatPrice},
+            {"length", length},
+            {"lowercase", lowercase},
+            {"round", round},
+            {"truncate", truncate},
+            {"uppercase", uppercase}};
+    }
+
+    void FilterRegistry::add(const std::string &name, FilterFunction function)
+    {
+        functions[name] = function;
+    }
+
+    FilterFunction FilterRegistry::find(const std::string &name) const
+    {
+        auto it = functions.find(name);
+        return it == functions.end() ? nullptr : it->second;
+    }
+
+    std::string_view formatNumber(const json &value, char (&buffer)[32])
+    {
+        std::to_chars_result result;
+        if (value.is_number_unsigned())
+            result = std::to_chars(buffer, buffer + sizeof(buffer), value.get<uint64_t>());
+        else if (value.is_number_integer())
+            result = std::to_chars(buffer, buffer + sizeof(buffer), value.get<int64_t>());
+        else
+            result = std::to_chars(buffer, buffer + sizeof(buffer), value.get<double>());
+        return std::string_view(buffer, result.ptr - buffer);
+    }
+
+    std::string toText(const json &value)
+    {
+        if (value.is_boolean())
+            return value.get<bool>() ? "true" : "false";
+        if (value.is_number())
+        {
+            char buffer[32];
+            return std::string(formatNumber(value, buffer));
+        }
+        if (value.is_string())
+            return value.get<std::string>();
+        return "";
+    }
+}
@@ -0,0 +1,130 @@
+#include "HtmlEscape.hpp"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define NERVA_ESCAPE_X86 1
+#endif
+
+namespace Nerva
+{
+    namespace
+    {
+        bool isSpecial(char c)
+        {
+            return c == '&' || c == '<' || c == '>' || c == '"' || c == '\'';
+        }
+
+        std::string_view entityFor(char c)
+        {
+            switch (c)
+            {
+            case '&':
+                return "&amp;";
+            case '<':
+                return "&lt;";
+            case '>':
+                return "&gt;";
+            case '"':
+                return "&quot;";
+            default:
+                return "&#39;";
+            }
+        }
+
+        size_t findScalar(const char *data, size_t size, size_t pos)
+        {
+            while (pos < size && !isSpecial(data[pos]))
+                ++pos;
+            return pos;
+        }
+
+#ifdef NERVA_ESCAPE_X86
+        // SSE2 is part of x86-64, so this path needs no runtime check.
+        size_t findSse2(const char *data, size_t size, size_t pos)
+        {
+            const __m128i amp = _mm_set1_epi8('&');
+            const __m128i lt = _mm_set1_epi8('<');
+            const __m128i gt = _mm_set1_epi8('>');
+            const __m128i quot = _mm_set1_epi8('"');
+            const __m128i apos = _mm_set1_epi8('\'');
+
+            for (; pos + 16 <= size; pos += 16)
+            {
+                __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + pos));
+                __m128i hits = _mm_or_si128(
+                    _mm_or_si128(_mm_cmpeq_epi8(chunk, amp), _mm_cmpeq_epi8(chunk, lt)),
+                    _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, gt), _mm_cmpeq_epi8(chunk, quot)),
+                                 _mm_cmpeq_epi8(chunk, apos)));
+
+                int mask = _mm_movemask_epi8(hits);
+                if (mask)
+                    return pos + __builtin_ctz(mask);
+            }
+
+            return findScalar(data, size, pos);
+        }
+
+        __attribute__((target("avx2"))) size_t findAvx2(const char *data, size_t size, size_t pos)
+        {
+            const __m256i amp = _mm256_set1_epi8('&');
+            const __m256i lt = _mm256_set1_epi8('<');
+            const __m256i gt = _mm256_set1_epi8('>');
+            const __m256i quot = _mm256_set1_epi8('"');
+            const __m256i apos = _mm256_set1_epi8('\'');
+
+            for (; pos + 32 <= size; pos += 32)
+            {
+                __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + pos));
+                __m256i hits = _mm256_or_si256(
+                    _mm256_or_si256(_mm256_cmpeq_epi8(chunk, amp), _mm256_cmpeq_epi8(chunk, lt)),
+                    _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, gt), _mm256_cmpeq_epi8(chunk, quot)),
+                                    _mm256_cmpeq_epi8(chunk, apos)));
+
+                unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(hits));
+                if (mask)
+                    return pos + __builtin_ctz(mask);
+            }
+
+            return findSse2(data, size, pos);
+        }
+
+        using FindFn = size_t (*)(const char *, size_t, size_t);
+
+        FindFn selectFind()
+        {
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2") ? findAvx2 : findSse2;
+        }
+#endif
+    }
+
+    size_t findHtmlSpecial(std::string_view text, size_t from)
+    {
+#ifdef NERVA_ESCAPE_X86
+        // Entering 256-bit code has a fixed cost (a few hundred ns on some
+        // virtualized hosts), so AVX2 is only worth it for long runs.
+        static const FindFn find = selectFind();
+        if (text.size() - from < 4096)
+            return findSse2(text.data(), text.size(), from);
+        return find(text.data(), text.size(), from);
+#else
+        return findScalar(text.data(), text.size(), from);
+#endif
+    }
+
+    void appendEscaped(std::string_view text, Http::OutputBuffer &out)
+    {
+        size_t pos = 0;
+        while (pos < text.size())
+        {
+            size_t special = findHtmlSpecial(text, pos);
+            if (special > pos)
+                out.append(text.substr(pos, special - pos));
+            if (special == text.size())
+                break;
+
+            out.append(entityFor(text[special]));
+            pos = special + 1;
+        }
+    }
+}
@@ -0,0 +1,472 @@
+#include "Template.hpp"
+#include "Filters.hpp"
+
+#include <charconv>
+#include <stdexcept>
+
+namespace Nerva
+{
+    namespace
+    {
+        enum class Terminator
+        {
+            End,
+            EndFor,
+            EndIf,
+            EndCache,
+            Else
+        };
+
+        std::string_view trim(std::string_view s)
+        {
+            size_t start = s.find_first_not_of(" \t\n\r");
+            if (start == std::string_view::npos)
+                return {};
+            size_t end = s.find_last_not_of(" \t\n\r");
+            return s.substr(start, end - start + 1);
+        }
+
+        bool startsWithWord(std::string_view tag, std::string_view word)
+        {
+            return tag.size() > word.size() && tag.substr(0, word.size()) == word &&
+                   (tag[word.size()] == ' ' || tag[word.size()] == '\t');
+        }
+
+        std::string_view unquote(std::string_view s)
+        {
+            if (s.size() >= 2 && (s.front() == '"' || s.front() == '\'') && s.back() == s.front())
+                return s.substr(1, s.size() - 2);
+            return s;
+        }
+
+        // Finds needle outside of quoted literals.
+        size_t findUnquoted(std::string_view s, std::string_view needle, size_t from = 0)
+        {
+            char quote = 0;
+            for (size_t i = from; i < s.size(); ++i)
+            {
+                char c = s[i];
+                if (quote)
+                {
+                    if (c == quote)
+                        quote = 0;
+                }
+                else if (c == '"' || c == '\'')
+                {
+                    quote = c;
+                }
+                else if (s.substr(i, needle.size()) == needle)
+                {
+                    return i;
+                }
+            }
+            return std::string_view::npos;
+        }
+
+        bool parseLiteral(std::string_view operand, json &literal)
+        {
+            if (operand.empty())
+                return false;
+
+            if (operand.front() == '"' || operand.front() == '\'')
+            {
+                literal = std::string(unquote(operand));
+                return true;
+            }
+            if (operand == "true" || operand == "false")
+            {
+                literal = operand == "true";
+                return true;
+            }
+
+            const char *begin = operand.data();
+            const char *end = begin + operand.size();
+
+            long long integer;
+            auto [intEnd, intErr] = std::from_chars(begin, end, integer);
+            if (intErr == std::errc() && intEnd == end)
+            {
+                literal = integer;
+                return true;
+            }
+
+            double number;
+            auto [numEnd, numErr] = std::from_chars(begin, end, number);
+            if (numErr == std::errc() && numEnd == end)
+            {
+                literal = number;
+                return true;
+            }
+
+            return false;
+        }
+
+        std::vector<PathSegment> parsePath(std::string_view path)
+        {
+            std::vector<PathSegment> segments;
+            size_t pos = 0;
+
+            while (pos <= path.size())
+            {
+                size_t dot = path.find('.', pos);
+                std::string_view part = path.substr(pos, dot == std::string_view::npos ? std::string_view::npos : dot - pos);
+
+                size_t bracket = part.find('[');
+                segments.push_back({std::string(part.substr(0, bracket))});
+
+                while (bracket != std::string_view::npos)
+                {
+                    size_t close = part.find(']', bracket);
+                    if (close == std::string_view::npos)
+                        break;
+
+                    PathSegment index;
+                    index.isIndex = true;
+                    std::from_chars(part.data() + bracket + 1, part.data() + close, index.index);
+                    segments.push_back(index);
+
+                    bracket = part.find('[', close);
+                }
+
+                if (dot == std::string_view::npos)
+                    break;
+                pos = dot + 1;
+            }
+
+            return segments;
+        }
+
+        // Comma-separated literals; a bare word is taken as a string.
+        FilterArguments parseArguments(std::string_view source)
+        {
+            FilterArguments arguments;
+            size_t pos = 0;
+
+            while (pos <= source.size())
+            {
+                size_t comma = findUnquoted(source, ",", pos);
+                std::string_view argument = trim(source.substr(pos, comma == std::string_view::npos ? std::string_view::npos : comma - pos));
+
+                json value;
+                if (!parseLiteral(argument, value))
+                    value = std::string(argument);
+                arguments.push_back(std::move(value));
+
+                if (comma == std::string_view::npos)
+                    break;
+                pos = comma + 1;
+            }
+
+            return arguments;
+        }
+
+        Expression parseExpression(std::string_view source)
+        {
+            Expression expr;
+
+            size_t pipe = findUnquoted(source, "|");
+            std::string_view operand = trim(source.substr(0, pipe));
+
+            if (parseLiteral(operand, expr.literal))
+                expr.isLiteral = true;
+            else
+                expr.path = parsePath(operand);
+
+            while (pipe != std::string_view::npos)
+            {
+                size_t next = findUnquoted(source, "|", pipe + 1);
+                std::string_view filter = trim(source.substr(pipe + 1, next == std::string_view::npos ? std::string_view::npos : next - pipe - 1));
+
+                size_t colon = filter.find(':');
+                std::string_view name = trim(filter.substr(0, colon));
+                if (name == "raw")
+                {
+                    expr.raw = true;
+                }
+                else
+                {
+                    Filter parsed{std::string(name), {}, nullptr};
+                    if (colon != std::string_view::npos)
+                        parsed.arguments = parseArguments(filter.substr(colon + 1));
+                    expr.filters.push_back(std::move(parsed));
+                }
+                pipe = next;
+            }
+
+            return expr;
+        }
+
+        // "product-{it.id}" becomes the literal "product-" followed by it.id.
+        std::vector<Expression> parseKey(std::string_view key)
+        {
+            std::vector<Expression> parts;
+            size_t pos = 0;
+
+            while (pos < key.size())
+            {
+                size_t open = key.find('{', pos);
+                size_t close = open == std::string_view::npos ? open : key.find('}', open + 1);
+                if (close == std::string_view::npos)
+                    open = key.size();
+
+                if (open > pos)
+                {
+                    Expression text;
+                    text.isLiteral = true;
+                    text.literal = std::string(key.substr(pos, open - pos));
+                    parts.push_back(std::move(text));
+                }
+                if (open == key.size())
+                    break;
+
+                parts.push_back(parseExpression(key.substr(open + 1, close - open - 1)));
+                pos = close + 1;
+            }
+
+            return parts;
+        }
+
+        Condition parseCondition(std::string_view source)
+        {
+            Condition condition;
+
+            source = trim(source);
+            if (startsWithWord(source, "not"))
+            {
+                condition.negate = true;
+                source = trim(source.substr(3));
+            }
+
+            static const std::pair<std::string_view, Condition::Op> operators[] = {
+                {"==", Condition::Op::Equal},
+                {"!=", Condition::Op::NotEqual},
+                {">=", Condition::Op::GreaterEqual},
+                {"<=", Condition::Op::LessEqual},
+                {">", Condition::Op::Greater},
+                {"<", Condition::Op::Less}};
+
+            for (const auto &[token, op] : operators)
+            {
+                size_t pos = findUnquoted(source, token);
+                if (pos != std::string_view::npos)
+                {
+                    condition.op = op;
+                    condition.left = parseExpression(source.substr(0, pos));
+                    condition.right = parseExpression(source.substr(pos + token.size()));
+                    return condition;
+                }
+            }
+
+            condition.left = parseExpression(source);
+            return condition;
+        }
+
+        void resolveFilters(Expression &expr, const FilterRegistry &filters)
+        {
+            for (Filter &filter : expr.filters)
+            {
+                filter.function = filters.find(filter.name);
+                if (!filter.function)
+                    throw std::runtime_error("Unknown filter '" + filter.name + "'");
+            }
+        }
+
+        void resolveFilters(std::vector<Node> &nodes, const FilterRegistry &filters)
+        {
+            for (Node &node : nodes)
+            {
+                resolveFilters(node.expr, filters);
+                resolveFilters(node.condition.left, filters);
+                resolveFilters(node.condition.right, filters);
+                for (Expression &part : node.cacheKey)
+                    resolveFilters(part, filters);
+
+                resolveFilters(node.body, filters);
+                resolveFilters(node.elseBody, filters);
+            }
+        }
+
+        class Parser
+        {
+        public:
+            explicit Parser(std::string_view source) : source(source) {}
+
+            void parse(std::vector<Node> &nodes)
+            {
+                // Stray end tags at the top level are dropped.
+                while (parseBlock(nodes) != Terminator::End)
+                {
+                }
+            }
+
+        private:
+            std::string_view source;
+            size_t pos = 0;
+
+            Terminator parseBlock(std::vector<Node> &nodes)
+            {
+                while (pos < source.size())
+                {
+                    size_t open = source.find("{{", pos);
+                    size_t close = open == std::string_view::npos ? open : source.find("}}", open + 2);
+
+                    if (close == std::string_view::npos)
+                    {
+                        addText(nodes, source.substr(pos));
+                        pos = source.size();
+                        break;
+                    }
+
+                    addText(nodes, source.substr(pos, open - pos));
+                    std::string_view tag = trim(source.substr(open + 2, close - open - 2));
+                    pos = close + 2;
+
+                    if (tag == "endfor")
+                        return Terminator::EndFor;
+                    if (tag == "endif")
+                        return Terminator::EndIf;
+                    if (tag == "endcache")
+                        return Terminator::EndCache;
+                    if (tag == "else")
+                        return Terminator::Else;
+
+                    if (startsWithWord(tag, "for"))
+                        parseFor(nodes, tag.substr(3));
+                    else if (startsWithWord(tag, "if"))
+                        parseIf(nodes, tag.substr(2));
+                    else if (startsWithWord(tag, "include"))
+                        parseInclude(nodes, trim(tag.substr(7)));
+                    else if (startsWithWord(tag, "cache"))
+                        parseCache(nodes, trim(tag.substr(5)));
+                    else if (startsWithWord(tag, "asset"))
+                        parseAsset(nodes, trim(tag.substr(5)));
+                    else if (!tag.empty())
+                    {
+                        Node node;
+                        node.kind = Node::Kind::Output;
+                        node.expr = parseExpression(tag);
+                        nodes.push_back(std::move(node));
+                    }
+                }
+
+                return Terminator::End;
+            }
+
+            // {{ asset "css/app.css" }} is {{ "css/app.css" | asset }}.
+            void parseAsset(std::vector<Node> &nodes, std::string_view spec)
+            {
+                Node node;
+                node.kind = Node::Kind::Output;
+                node.expr = parseExpression(spec);
+                node.expr.filters.insert(node.expr.filters.begin(), Filter{"asset", {}, nullptr});
+                nodes.push_back(std::move(node));
+            }
+
+            void addText(std::vector<Node> &nodes, std::string_view text)
+            {
+                if (text.empty())
+                    return;
+
+                Node node;
+                node.kind = Node::Kind::Text;
+                node.text = text;
+                nodes.push_back(std::move(node));
+            }
+
+            void parseFor(std::vector<Node> &nodes, std::string_view spec)
+            {
+                size_t inPos = spec.find(" in ");
+                if (inPos == std::string_view::npos)
+                    return;
+
+                Node node;
+                node.kind = Node::Kind::For;
+                node.expr = parseExpression(spec.substr(inPos + 4));
+
+                std::string_view vars = spec.substr(0, inPos);
+                size_t comma = vars.find(',');
+                node.itemVar = std::string(trim(vars.substr(0, comma)));
+                if (comma != std::string_view::npos)
+                    node.indexVar = std::string(trim(vars.substr(comma + 1)));
+
+                Terminator end;
+                while ((end = parseBlock(node.body)) != Terminator::EndFor && end != Terminator::End)
+                {
+                }
+
+                nodes.push_back(std::move(node));
+            }
+
+            void parseIf(std::vector<Node> &nodes, std::string_view condition)
+            {
+                Node node;
+                node.kind = Node::Kind::If;
+                node.condition = parseCondition(condition);
+
+                Terminator end;
+                while ((end = parseBlock(node.body)) != Terminator::EndIf && end != Terminator::Else && end != Terminator::End)
+                {
+                }
+
+                if (end == Terminator::Else)
+                {
+                    while ((end = parseBlock(node.elseBody)) != Terminator::EndIf && end != Terminator::End)
+                    {
+                    }
+                }
+
+                nodes.push_back(std::move(node));
+            }
+
+            void parseInclude(std::vector<Node> &nodes, std::string_view spec)
+            {
+                Node node;
+                node.kind = Node::Kind::Include;
+
+                size_t withPos = spec.find(" with ");
+                if (withPos != std::string_view::npos)
+                {
+                    node.hasWith = true;
+                    node.expr = parseExpression(spec.substr(withPos + 6));
+                    spec = trim(spec.substr(0, withPos));
+                }
+
+                node.templateName = std::string(unquote(spec));
+                nodes.push_back(std::move(node));
+            }
+
+            void parseCache(std::vector<Node> &nodes, std::string_view spec)
+            {
+                Node node;
+                node.kind = Node::Kind::Cache;
+
+                size_t keyEnd = spec.find_first_of(" \t");
+                if (!spec.empty() && (spec.front() == '"' || spec.front() == '\''))
+                {
+                    size_t close = spec.find(spec.front(), 1);
+                    keyEnd = close == std::string_view::npos ? close : close + 1;
+                }
+                node.cacheKey = parseKey(unquote(spec.substr(0, keyEnd)));
+
+                std::string_view options = keyEnd == std::string_view::npos ? std::string_view() : spec.substr(keyEnd);
+                size_t ttlPos = options.find("ttl=");
+                if (ttlPos != std::string_view::npos)
+                    std::from_chars(options.data() + ttlPos + 4, options.data() + options.size(), node.ttl);
+
+                Terminator end;
+                while ((end = parseBlock(node.body)) != Terminator::EndCache && end != Terminator::End)
+                {
+                }
+
+                nodes.push_back(std::move(node));
+            }
+        };
+    }
+
+    CompiledTemplate::CompiledTemplate(std::string source, const FilterRegistry *filters) : text(std::move(source))
+    {
+        Parser(text).parse(root);
+        if (filters)
+            resolveFilters(root, *filters);
+    }
+}
@@ -0,0 +1,66 @@
+#include "TemplateCache.hpp"
+
+#include <mutex>
+
+namespace Nerva
+{
+    TemplateCache::TemplateCache(size_t shardCount)
+    {
+        if (shardCount == 0)
+            shardCount = 1;
+
+        for (size_t i = 0; i < shardCount; ++i)
+        {
+            shards.push_back(std::make_unique<Shard>());
+        }
+    }
+
+    TemplateCache::Compiled TemplateCache::get(const std::string &name, const Loader &loader)
+    {
+        if (auto compiled = find(name))
+            return compiled;
+
+        Compiled compiled = loader(name);
+
+        Shard &shard = shardFor(name);
+        std::unique_lock<std::shared_mutex> lock(shard.mtx);
+        return shard.entries.try_emplace(name, std::move(compiled)).first->second;
+    }
+
+    TemplateCache::Compiled TemplateCache::find(const std::string &name)
+    {
+        Shard &shard = shardFor(name);
+        std::shared_lock<std::shared_mutex> lock(shard.mtx);
+
+        auto it = shard.entries.find(name);
+        return it != shard.entries.end() ? it->second : nullptr;
+    }
+
+    void TemplateCache::put(const std::string &name, Compiled compiled)
+    {
+        Shard &shard = shardFor(name);
+        std::unique_lock<std::shared_mutex> lock(shard.mtx);
+        shard.entries[name] = std::move(compiled);
+    }
+
+    void TemplateCache::erase(const std::string &name)
+    {
+        Shard &shard = shardFor(name);
+        std::unique_lock<std::shared_mutex> lock(shard.mtx);
+        shard.entries.erase(name);
+    }
+
+    void TemplateCache::clear()
+    {
+        for (auto &shard : shards)
+        {
+            std::unique_lock<std::shared_mutex> lock(shard->mtx);
+            shard->entries.clear();
+        }
+    }
+
+    TemplateCache::Shard &TemplateCache::shardFor(const std::string &name)
+    {
+        return *shards[std::hash<std::string>{}(name) % shards.size()];
+    }
+}
@@ -0,0 +1,149 @@
+#include "ViewRuntime.hpp"
+#include "HtmlEscape.hpp"
+#include "Filters.hpp"
+
+#include <charconv>
+#include <memory>
+
+namespace Nerva::View
+{
+    namespace
+    {
+        std::unique_ptr<Registry> &registry()
+        {
+            static std::unique_ptr<Registry> instance;
+            return instance;
+        }
+    }
+
+    bool Register(std::vector<std::string> filters, std::initializer_list<Compiled> views)
+    {
+        auto compiled = std::make_unique<Registry>();
+        compiled->filters = std::move(filters);
+        for (const Compiled &view : views)
+        {
+            compiled->views.emplace(view.name, view.render);
+        }
+
+        registry() = std::move(compiled);
+        return true;
+    }
+
+    const Registry *Registered()
+    {
+        return registry().get();
+    }
+
+    namespace
+    {
+        template <typename T>
+        bool ordered(Condition::Op op, const T &left, const T &right)
+        {
+            switch (op)
+            {
+            case Condition::Op::Equal:
+                return left == right;
+            case Condition::Op::NotEqual:
+                return left != right;
+            case Condition::Op::Less:
+                return left < right;
+            case Condition::Op::LessEqual:
+                return left <= right;
+            case Condition::Op::Greater:
+                return left > right;
+            default:
+                return left >= right;
+            }
+        }
+
+        std::string_view formatNumber(const Value &value, char (&buffer)[32])
+        {
+            if (const json *node = value.node())
+                return Nerva::formatNumber(*node, buffer);
+
+            auto result = value.isInteger() ? std::to_chars(buffer, buffer + sizeof(buffer), value.integer())
+                                            : std::to_chars(buffer, buffer + sizeof(buffer), value.number());
+            return std::string_view(buffer, result.ptr - buffer);
+        }
+    }
+
+    void write(const Value &value, bool raw, Http::OutputBuffer &out)
+    {
+        if (value.isString())
+        {
+            if (raw)
+                out.append(value.string());
+            else
+                appendEscaped(value.string(), out);
+        }
+        else if (value.isNumber())
+        {
+            char buffer[32];
+            out.append(formatNumber(value, buffer));
+        }
+        else if (value.isBool())
+            out.append(value.boolean() ? "true" : "false");
+        else if (value.isObject())
+            out.append("[object]");
+        else if (value.isArray())
+            out.append("[array]");
+    }
+
+    bool truthy(const Value &value)
+    {
+        return (value.isBool() && value.boolean()) ||
+               (value.isNumber() && value.number() != 0) ||
+               (value.isString() && !value.string().empty()) ||
+               ((value.isArray() || value.isObject()) && value.size() != 0);
+    }
+
+    bool compare(Condition::Op op, const Value &left, const Value &right)
+    {
+        if (op == Condition::Op::Truthy)
+            return truthy(left);
+
+        if (left.node() && right.node())
+            return ordered(op, *left.node(), *right.node());
+
+        if (left.isNumber() && right.isNumber())
+        {
+            return left.isInteger() && right.isInteger() ? ordered(op, left.integer(), right.integer())
+                                                         : ordered(op, left.number(), right.number());
+        }
+        if (left.isString() && right.isString())
+            return ordered(op, left.string(), right.string());
+
+        json leftStorage, rightStorage;
+        return ordered(op, left.asJson(leftStorage), right.asJson(rightStorage));
+    }
+
+    std::string text(const Value &value)
+    {
+        if (const json *node = value.node())
+            return toText(*node);
+
+        if (value.isString())
+            return std::string(value.string());
+        if (value.isNumber())
+        {
+            char buffer[32];
+            return std::string(formatNumber(value, buffer));
+        }
+        if (value.isBool())
+            return value.boolean() ? "true" : "false";
+        return "";
+    }
+
+    Value element(const Value &value, size_t index, json &storage)
+    {
+        if (value.isArray())
+            return value.at(index);
+
+        if (value.isString() && index < value.string().size())
+        {
+            storage = std::string(1, value.string()[index]);
+            return storage;
+        }
+        return {};
+    }
+}
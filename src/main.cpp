@@ -11,11 +11,13 @@
 #include <system_error>
 #include <sstream>
 #include <map>
+#include <algorithm>
 
 #include "Server.hpp"
 #include "Middleware.hpp"
 #include "Json.hpp"
 #include "ViewEngine/NervaEngine.hpp"
+#include "EventLoop.hpp"
 
 #include "RateLimiter.hpp"
 #include "Cors.hpp"
@@ -27,6 +29,34 @@ std::map<std::string, std::string> users = {
 
 std::map<std::string, std::string> sessions;
 
+struct Shopper
+{
+    std::string name;
+    bool premium;
+    std::string cartItems;
+};
+NERVA_REFLECT(Shopper, name, premium, cartItems)
+
+struct Product
+{
+    std::string id;
+    std::string name;
+    double price;
+    bool inStock;
+};
+NERVA_REFLECT(Product, id, name, price, inStock)
+
+struct ProductPage
+{
+    std::string pageTitle;
+    bool showPromo;
+    std::string promoMessage;
+    Shopper user;
+    std::vector<Product> products;
+    std::vector<std::string> features;
+};
+NERVA_REFLECT(ProductPage, pageTitle, showPromo, promoMessage, user, products, features)
+
 int main()
 {
     Server server;
@@ -150,16 +180,16 @@ int main()
         };
         
         for (const auto& [name, value] : res.incomingCookies) {
-            data["allCookies"][name] = value;
+            data["allCookies"][std::string(name)] = std::string(value);
         }
         
         res.Render("cookies", data); });
 
     server.Get("/cookie-manager", {}, [](const Http::Request &req, Http::Response &res, auto next)
                {
-        std::string action = req.getQuery("action");
-        std::string name = req.getQuery("name");
-        std::string value = req.getQuery("value");
+        std::string action(req.getQuery("action"));
+        std::string name(req.getQuery("name"));
+        std::string value(req.getQuery("value"));
         
         if (action == "set" && !name.empty()) {
             Http::CookieOptions opts;
@@ -177,16 +207,40 @@ int main()
         res.setSignedCookie("secure", "ITS VERY SAFE", "123", secureOpts);
         res << 200 << "Test ID: " << req.getParam("id") << " Cookie: " << res.getSignedCookie("secure", "123").value_or(""); });
 
-    server.Post("/upload", {}, [](const Http::Request &req, Http::Response &res, auto next)
-                {
+    server.Post("/upload").Then([&server](Http::Request &req, Http::Response &res) -> Nerva::Task<void>
+                                {
         auto fileData = req.getFormData("file");
         if (fileData.isFile && !fileData.file.empty()) {
-            fileData.file.save("./public/" + fileData.filename);
+            try {
+                co_await server.Offload([&] { fileData.file.save("./public/" + fileData.filename); });
+            } catch (const Nerva::OffloadRejected &) {
+                res << 503 << "Server busy, try again later.";
+                co_return;
+            }
             res << 200 << "File uploaded successfully: " << fileData.filename;
         } else {
             res << 400 << "File upload failed.";
         } });
 
+    server.Post("/upload-stream").Stream().Then([](Http::Request &req, Http::Response &res) -> Nerva::Task<void>
+                                                {
+        size_t lines = 0;
+        for (std::string_view chunk = co_await req.stream().read(); !chunk.empty(); chunk = co_await req.stream().read())
+            lines += std::count(chunk.begin(), chunk.end(), '\n');
+        res << 200 << "Received " << std::to_string(req.stream().received()) << " bytes, " << std::to_string(lines) << " lines"; });
+
+    server.Get("/export.csv").Then([](Http::Request &req, Http::Response &res) -> Nerva::Task<void>
+                                   {
+        res.setHeader("Content-Type", "text/csv");
+        res.write("id,name,email\n");
+
+        std::string row;
+        for (int id = 1; id <= 100000; ++id) {
+            row = std::to_string(id) + ",user" + std::to_string(id) + ",user" + std::to_string(id) + "@example.com\n";
+            if (!res.write(row))
+                co_await res.drain();
+        } });
+
     server.Post("/json", {}, [](const Http::Request &req, Http::Response &res, auto next)
                 {
         const std::string jsonResponse = R"({"message": "JSON POST successful!"})";
@@ -195,9 +249,14 @@ int main()
     server.Get("/image-test", {}, [](const Http::Request &req, Http::Response &res, auto next)
                { res.SendFile("./public/a.jpg"); });
 
+    server.Get("/delayed").Then([](Http::Request &req, Http::Response &res) -> Nerva::Task<void>
+                                {
+        co_await Nerva::Sleep(std::chrono::milliseconds(100));
+        res << 200 << "Waited 100ms without holding a worker thread"; });
+
     Middleware authMiddleware = Middleware([](Http::Request &req, Http::Response &res, auto next)
                                            {
-        std::string token = req.getQuery("token");
+        std::string_view token = req.getQuery("token");
         if (token != "123") {
             res << 401 << "Unauthorized";
             return;
@@ -222,8 +281,8 @@ int main()
     apiRouter.Get("/users", {}, [](const Http::Request &req, Http::Response &res, auto next)
                   { res << 200 << "User list"; });
 
-    apiRouter.Get("/users/:id", {}, [](const Http::Request &req, Http::Response &res, auto next)
-                  { res << 200 << "User ID: " << req.getParam("id"); });
+    apiRouter.Get<"/users/{id:int}">([](const Http::Request &req, Http::Response &res, int id)
+                                     { res << 200 << "User ID: " << std::to_string(id); });
 
     server.Use("/api", apiRouter);
 
@@ -257,25 +316,22 @@ int main()
             res << 200 << "Blog Categories";
         }); });
 
-    server.Get("/products").Then([](const Http::Request &req, Http::Response &res, auto next)
-                                 {
-        nlohmann::json data = {
-            {"pageTitle", "Super Products"},
-            {"showPromo", true},
-            {"promoMessage", "TODAY'S SPECIAL DISCOUNT!"},
-            {"user", {
-                {"name", "Ayşe Demir"},
-                {"premium", true},
-                {"cartItems", "3"}
-            }},
-            {"products", {
-                {{"id", "101"}, {"name", "Smartphone"}, {"price", 7999.90}, {"inStock", true}},
-                {{"id", "205"}, {"name", "Laptop"}, {"price", 12499.99}, {"inStock", false}},
-                {{"id", "302"}, {"name", "Wireless Headphones"}, {"price", 1299.50}, {"inStock", true}}
-            }},
-            {"features", {"Fast Delivery", "Free Returns", "Original Product Guarantee"}}
-        };
-        res.Render("productPage", data); });
+    server.Get("/products")
+        .Cache({.ttl = std::chrono::seconds(1), .vary = {"Cookie:session_id"}})
+        .Coalesce({.maxWait = std::chrono::milliseconds(200), .vary = {"Cookie:session_id", "Header:Origin"}})
+        .Then([](const Http::Request &req, Http::Response &res, auto next)
+              {
+        static const ProductPage page{
+            .pageTitle = "Super Products",
+            .showPromo = true,
+            .promoMessage = "TODAY'S SPECIAL DISCOUNT!",
+            .user = {"Ayşe Demir", true, "3"},
+            .products = {
+                {"101", "Smartphone", 7999.90, true},
+                {"205", "Laptop", 12499.99, false},
+                {"302", "Wireless Headphones", 1299.50, true}},
+            .features = {"Fast Delivery", "Free Returns", "Original Product Guarantee"}};
+        res.Render("productPage", page); });
 
     server.Get("/middleware-demo", {}, [](const Http::Request &req, Http::Response &res, auto next)
                {
@@ -295,7 +351,7 @@ int main()
 
     server.Get("/auth-demo", {}, [](const Http::Request &req, Http::Response &res, auto next)
                {
-        std::string token = req.getQuery("token");
+        std::string_view token = req.getQuery("token");
         if (token == "secret123") {
             std::cout << "Authentication successful" << std::endl;
             next();
@@ -0,0 +1,154 @@
+// Times a 5-deep handler chain (4 middlewares + route handler); run by
+// `make bench-chain`.
+//
+//   HandlerChainBench [iterations]
+//
+// Both chains are built the way Router::tryDispatch builds them, once with the
+// self-referencing std::function continuation the router used to pass down and
+// once with Next. Each stage is a virtual call, as IHandler::Handle is, and the
+// step lambda captures as much state as the router's does.
+
+#include "Next.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct Context
+    {
+        std::string path = "/products/42";
+        size_t visited = 0;
+    };
+
+    struct LegacyStage
+    {
+        virtual ~LegacyStage() = default;
+        virtual void Handle(Context &ctx, std::function<void()> next) = 0;
+    };
+
+    struct LegacyMiddleware : LegacyStage
+    {
+        void Handle(Context &ctx, std::function<void()> next) override
+        {
+            ctx.visited++;
+            next();
+        }
+    };
+
+    struct Stage
+    {
+        virtual ~Stage() = default;
+        virtual void Handle(Context &ctx, Next next) = 0;
+    };
+
+    struct NextMiddleware : Stage
+    {
+        void Handle(Context &ctx, Next next) override
+        {
+            ctx.visited++;
+            next();
+        }
+    };
+
+    constexpr size_t Depth = 4;
+
+    void runLegacy(Context &ctx, const std::vector<LegacyStage *> &middlewares,
+                   const std::function<void(Context &, std::function<void()>)> &handler)
+    {
+        size_t middlewareIndex = 0;
+        size_t handlerIndex = 0;
+        const std::string *fullPath = &ctx.path;
+
+        std::function<void()> next = [&]()
+        {
+            if (middlewareIndex < middlewares.size())
+            {
+                middlewares[middlewareIndex++]->Handle(ctx, next);
+            }
+            else if (handlerIndex++ == 0 && !fullPath->empty())
+            {
+                handler(ctx, next);
+            }
+        };
+
+        next();
+    }
+
+    void runNext(Context &ctx, const std::vector<Stage *> &middlewares,
+                 const std::function<void(Context &, Next)> &handler)
+    {
+        size_t middlewareIndex = 0;
+        size_t handlerIndex = 0;
+        const std::string *fullPath = &ctx.path;
+
+        Next next;
+        auto step = [&]()
+        {
+            if (middlewareIndex < middlewares.size())
+            {
+                middlewares[middlewareIndex++]->Handle(ctx, next);
+            }
+            else if (handlerIndex++ == 0 && !fullPath->empty())
+            {
+                handler(ctx, next);
+            }
+        };
+        next = step;
+
+        next();
+    }
+
+    template <typename F>
+    double nanosPerRequest(size_t iterations, F &&run)
+    {
+        for (size_t i = 0; i < iterations / 10; ++i)
+            run();
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; ++i)
+            run();
+        auto elapsed = std::chrono::steady_clock::now() - start;
+
+        return std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    size_t iterations = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2000000;
+
+    std::vector<LegacyMiddleware> legacyStorage(Depth);
+    std::vector<LegacyStage *> legacy;
+    for (auto &mw : legacyStorage)
+        legacy.push_back(&mw);
+
+    std::vector<NextMiddleware> nextStorage(Depth);
+    std::vector<Stage *> stages;
+    for (auto &mw : nextStorage)
+        stages.push_back(&mw);
+
+    std::function<void(Context &, std::function<void()>)> legacyHandler =
+        [](Context &ctx, std::function<void()>)
+    { ctx.visited++; };
+    std::function<void(Context &, Next)> nextHandler = [](Context &ctx, Next)
+    { ctx.visited++; };
+
+    Context ctx;
+    double legacyNs = nanosPerRequest(iterations, [&]()
+                                      { runLegacy(ctx, legacy, legacyHandler); });
+    double nextNs = nanosPerRequest(iterations, [&]()
+                                    { runNext(ctx, stages, nextHandler); });
+
+    if (ctx.visited == 0)
+        return 1;
+
+    std::cout << "chain depth " << Depth + 1 << ", " << iterations << " iterations\n"
+              << "  std::function  " << legacyNs << " ns/request\n"
+              << "  Next           " << nextNs << " ns/request\n";
+    return 0;
+}
@@ -0,0 +1,94 @@
+// Times Nerva::Engine renders of the bundled views; run by `make bench-views`.
+//
+//   TemplateBench [iterations] [views directory]
+//
+// Renders productPage (with 3 and with 200 products, header, footer and
+// productCard included) and dashboard from json contexts, the way the example
+// routes in main.cpp build them, and prints microseconds per render. Views
+// linked in by `make views` are not part of this binary, so every render goes
+// through the interpreter.
+
+#include "Engine.hpp"
+#include "Response.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+namespace
+{
+    using Nerva::json;
+
+    json productPage(size_t productCount)
+    {
+        json products = json::array();
+        for (size_t i = 0; i < productCount; ++i)
+        {
+            products.push_back({{"id", std::to_string(100 + i)},
+                                {"name", "Product " + std::to_string(i)},
+                                {"price", 999.90 + i},
+                                {"inStock", i % 3 != 0}});
+        }
+
+        return {{"pageTitle", "Super Products"},
+                {"showPromo", true},
+                {"promoMessage", "TODAY'S SPECIAL DISCOUNT!"},
+                {"user", {{"name", "Ayşe Demir"}, {"premium", true}, {"cartItems", "3"}}},
+                {"products", products},
+                {"features", {"Fast Delivery", "Free Returns", "Original Product Guarantee"}}};
+    }
+
+    json dashboard()
+    {
+        return {{"pageTitle", "Dashboard - Nerva HTTP Server"},
+                {"username", "admin"},
+                {"sessionId", "sess_1700000000_admin"},
+                {"loginTime", "1700000000"}};
+    }
+
+    double microsPerRender(Nerva::Engine &engine, const std::string &view, const json &context, size_t iterations)
+    {
+        Http::Response res;
+        size_t bytes = 0;
+
+        auto renderOnce = [&]()
+        {
+            res.reset();
+            engine.render(res, view, context);
+            bytes += res.output.size();
+        };
+
+        for (size_t i = 0; i < iterations / 10 + 1; ++i)
+            renderOnce();
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; ++i)
+            renderOnce();
+        auto elapsed = std::chrono::steady_clock::now() - start;
+
+        if (bytes == 0)
+            std::cerr << view << " rendered nothing" << std::endl;
+
+        return std::chrono::duration<double, std::micro>(elapsed).count() / iterations;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    size_t iterations = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 20000;
+    std::string viewsDir = argc > 2 ? argv[2] : "./views";
+
+    Nerva::Engine engine;
+    engine.setViewsDirectory(viewsDir);
+
+    json small = productPage(3);
+    json large = productPage(200);
+    json board = dashboard();
+
+    std::cout << iterations << " renders each, us per render\n"
+              << "  productPage, 3 products    " << microsPerRender(engine, "productPage", small, iterations) << "\n"
+              << "  productPage, 200 products  " << microsPerRender(engine, "productPage", large, iterations / 20 + 1) << "\n"
+              << "  dashboard                  " << microsPerRender(engine, "dashboard", board, iterations) << "\n";
+    return 0;
+}
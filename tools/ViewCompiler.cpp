@@ -0,0 +1,520 @@
+// Turns views into C++ render functions for Nerva::Engine; run by `make views`.
+//
+//   ViewCompiler [--filter=name]... <output.cpp> <view.html>...
+//
+// Filters must be built in or named with --filter (the ones the application
+// registers with RegisterFilter); any other name fails the build.
+//
+// Literal HTML becomes string constants referenced straight into the response,
+// loops and conditionals become native code, and loop variables are resolved
+// at compile time. The output registers itself with View::Register, so the
+// engine renders these views without interpreting them.
+
+#include "Filters.hpp"
+#include "Template.hpp"
+
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    using namespace Nerva;
+
+    std::string quote(std::string_view text)
+    {
+        static const char digits[] = "01234567";
+        std::string out = "\"";
+        for (unsigned char c : text)
+        {
+            if (c == '"' || c == '\\')
+            {
+                out += '\\';
+                out += static_cast<char>(c);
+            }
+            else if (c == '\n')
+                out += "\\n";
+            else if (c == '\t')
+                out += "\\t";
+            else if (c < 0x20 || c >= 0x7f)
+            {
+                // Always three digits, so a following digit is not absorbed.
+                out += '\\';
+                out += digits[c >> 6];
+                out += digits[(c >> 3) & 7];
+                out += digits[c & 7];
+            }
+            else
+                out += static_cast<char>(c);
+        }
+        return out + "\"";
+    }
+
+    std::string identifier(std::string_view name)
+    {
+        std::string id = "render_";
+        for (char c : name)
+            id += std::isalnum(static_cast<unsigned char>(c)) ? c : '_';
+        return id;
+    }
+
+    // True if name occurs in code as a whole identifier.
+    bool uses(const std::string &code, const std::string &name)
+    {
+        for (size_t pos = code.find(name); pos != std::string::npos; pos = code.find(name, pos + 1))
+        {
+            size_t end = pos + name.size();
+            bool startOk = pos == 0 || !(std::isalnum(static_cast<unsigned char>(code[pos - 1])) || code[pos - 1] == '_');
+            bool endOk = end == code.size() || !(std::isalnum(static_cast<unsigned char>(code[end])) || code[end] == '_');
+            if (startOk && endOk)
+                return true;
+        }
+        return false;
+    }
+
+    class Generator
+    {
+    public:
+        Generator(std::map<std::string, std::string> views, const FilterRegistry &filters)
+            : views(std::move(views)), filters(filters) {}
+
+        std::string generate()
+        {
+            std::vector<std::unique_ptr<CompiledTemplate>> compiled;
+            std::ostringstream bodies;
+
+            for (const auto &[name, source] : views)
+            {
+                try
+                {
+                    compiled.push_back(std::make_unique<CompiledTemplate>(source, &filters));
+                }
+                catch (const std::runtime_error &e)
+                {
+                    throw std::runtime_error(name + ".html: " + e.what());
+                }
+
+                Context context{"scope", "out", true};
+                std::string body = emitNodes(compiled.back()->nodes(), context, 2);
+
+                bodies << "    void " << identifier(name)
+                       << "(Engine &engine, const Scope &scope, Output &out, const FilterFunction *filters)\n    {\n";
+                if (!uses(body, "engine"))
+                    bodies << "        (void)engine;\n";
+                if (!uses(body, "scope"))
+                    bodies << "        (void)scope;\n";
+                if (!uses(body, "filters"))
+                    bodies << "        (void)filters;\n";
+                bodies << body << "    }\n\n";
+            }
+
+            std::ostringstream file;
+            file << "// Generated by tools/ViewCompiler.cpp; do not edit.\n\n"
+                 << "#include \"ViewRuntime.hpp\"\n\n"
+                 << "namespace\n{\n"
+                 << "    using namespace Nerva;\n"
+                 << "    using View::Output;\n"
+                 << "    using View::Scope;\n\n";
+
+            for (const auto &[name, source] : views)
+                file << "    void " << identifier(name) << "(Engine &, const Scope &, Output &, const FilterFunction *);\n";
+            file << "\n"
+                 << constants.str() << "\n"
+                 << bodies.str();
+
+            file << "    const bool registered = View::Register(\n        {";
+            for (size_t i = 0; i < filterNames.size(); ++i)
+                file << (i ? ", " : "") << quote(filterNames[i]);
+            file << "},\n        {";
+            bool first = true;
+            for (const auto &[name, source] : views)
+            {
+                file << (first ? "" : ",\n         ") << "{" << quote(name) << ", " << identifier(name) << "}";
+                first = false;
+            }
+            file << "});\n}\n";
+
+            return file.str();
+        }
+
+    private:
+        struct Binding
+        {
+            std::string name;
+            std::string value;
+        };
+
+        struct Context
+        {
+            std::string scope;
+            std::string out;
+            bool streaming;
+        };
+
+        std::map<std::string, std::string> views;
+        const FilterRegistry &filters;
+        std::ostringstream constants;
+        std::map<std::string, std::string> names;
+        std::vector<std::string> filterNames;
+        std::vector<Binding> bindings;
+        int counter = 0;
+
+        std::string next(const char *prefix)
+        {
+            return prefix + std::to_string(++counter);
+        }
+
+        // File-scope std::string holding text, shared by equal values.
+        std::string name(const std::string &text)
+        {
+            auto it = names.find(text);
+            if (it != names.end())
+                return it->second;
+
+            std::string id = next("k");
+            constants << "    const std::string " << id << " = " << quote(text) << ";\n";
+            names.emplace(text, id);
+            return id;
+        }
+
+        size_t filterIndex(const std::string &filter)
+        {
+            for (size_t i = 0; i < filterNames.size(); ++i)
+            {
+                if (filterNames[i] == filter)
+                    return i;
+            }
+            filterNames.push_back(filter);
+            return filterNames.size() - 1;
+        }
+
+        static std::string pad(int depth)
+        {
+            return std::string(depth * 4, ' ');
+        }
+
+        // Emits statements leaving the expression's Value in the returned variable.
+        std::string emitExpression(const Expression &expr, const Context &context, int depth, std::ostringstream &code)
+        {
+            std::string value = next("v");
+            std::string storage = next("s");
+            std::string in = pad(depth);
+            std::ostringstream steps;
+
+            if (expr.isLiteral)
+            {
+                std::string literal = next("l");
+                constants << "    const json " << literal << " = json::parse(" << quote(expr.literal.dump()) << ");\n";
+                steps << in << "Value " << value << " = " << literal << ";\n";
+            }
+            else if (expr.path.empty() || expr.path.front().isIndex)
+            {
+                steps << in << "Value " << value << ";\n";
+            }
+            else
+            {
+                const std::string &root = expr.path.front().key;
+                std::string lookup;
+                for (auto it = bindings.rbegin(); it != bindings.rend(); ++it)
+                {
+                    if (it->name == root)
+                    {
+                        lookup = it->value;
+                        break;
+                    }
+                }
+                if (lookup.empty())
+                    lookup = context.scope + ".find(" + name(root) + ")";
+
+                steps << in << "Value " << value << " = " << lookup << ";\n";
+
+                for (size_t i = 1; i < expr.path.size(); ++i)
+                {
+                    const PathSegment &segment = expr.path[i];
+                    if (segment.isIndex)
+                        steps << in << value << " = View::element(" << value << ", " << segment.index << ", " << storage << ");\n";
+                    else
+                        steps << in << value << " = " << value << ".member(" << name(segment.key) << ");\n";
+                }
+            }
+
+            for (const Filter &filter : expr.filters)
+            {
+                std::string arguments = next("a");
+                constants << "    const FilterArguments " << arguments << " = json::parse("
+                          << quote(json(filter.arguments).dump()) << ").get<FilterArguments>();\n";
+
+                std::string function = "filters[" + std::to_string(filterIndex(filter.name)) + "]";
+                steps << in << storage << " = " << function << "(" << value << ".asJson(" << storage << "), " << arguments << ");\n"
+                      << in << value << " = " << storage << ";\n";
+            }
+
+            if (uses(steps.str(), storage))
+                code << in << "json " << storage << ";\n";
+            code << steps.str();
+
+            return value;
+        }
+
+        std::string emitNodes(const std::vector<Node> &nodes, const Context &context, int depth)
+        {
+            std::ostringstream code;
+            std::string in = pad(depth);
+
+            for (const Node &node : nodes)
+            {
+                switch (node.kind)
+                {
+                case Node::Kind::Text:
+                {
+                    std::string text = next("t");
+                    constants << "    constexpr std::string_view " << text << "(" << quote(node.text) << ", " << node.text.size() << ");\n";
+                    code << in << context.out << ".buffer.reference(" << text << ");\n";
+                    break;
+                }
+                case Node::Kind::Output:
+                {
+                    code << in << "{\n";
+                    std::string value = emitExpression(node.expr, context, depth + 1, code);
+                    code << in << "    View::write(" << value << ", " << (node.expr.raw ? "true" : "false") << ", " << context.out << ".buffer);\n"
+                         << in << "}\n";
+                    break;
+                }
+                case Node::Kind::If:
+                    emitIf(node, context, depth, code);
+                    break;
+                case Node::Kind::For:
+                    emitFor(node, context, depth, code);
+                    break;
+                case Node::Kind::Include:
+                    emitInclude(node, context, depth, code);
+                    break;
+                case Node::Kind::Cache:
+                    emitCache(node, context, depth, code);
+                    break;
+                }
+
+                if (context.streaming)
+                    code << in << "if (" << context.out << ".stream)\n"
+                         << in << "    " << context.out << ".flushIfFull();\n";
+            }
+
+            return code.str();
+        }
+
+        void emitIf(const Node &node, const Context &context, int depth, std::ostringstream &code)
+        {
+            std::string in = pad(depth);
+            const Condition &condition = node.condition;
+
+            code << in << "{\n";
+            std::string left = emitExpression(condition.left, context, depth + 1, code);
+
+            std::string test;
+            if (condition.op == Condition::Op::Truthy)
+            {
+                test = "View::truthy(" + left + ")";
+            }
+            else
+            {
+                static const char *ops[] = {"Truthy", "Equal", "NotEqual", "Less", "LessEqual", "Greater", "GreaterEqual"};
+                std::string right = emitExpression(condition.right, context, depth + 1, code);
+                test = std::string("View::compare(Condition::Op::") + ops[static_cast<int>(condition.op)] + ", " + left + ", " + right + ")";
+            }
+
+            code << in << "    if (" << (condition.negate ? "!" : "") << test << ")\n"
+                 << in << "    {\n"
+                 << emitNodes(node.body, context, depth + 2)
+                 << in << "    }\n";
+            if (!node.elseBody.empty())
+            {
+                code << in << "    else\n"
+                     << in << "    {\n"
+                     << emitNodes(node.elseBody, context, depth + 2)
+                     << in << "    }\n";
+            }
+            code << in << "}\n";
+        }
+
+        // Body with the loop frames it needs; frames only matter to includes,
+        // cache keys and unbound names, which look up through the scope chain.
+        std::string emitLoopBody(const Node &node, const Context &context, int depth,
+                                 const std::string &item, const std::string &index)
+        {
+            std::string in = pad(depth);
+            std::string itemScope = next("f");
+            std::string indexScope = next("f");
+            bool hasIndex = !node.indexVar.empty();
+
+            bindings.push_back({node.itemVar, item});
+            if (hasIndex)
+                bindings.push_back({node.indexVar, index});
+
+            Context inner = context;
+            inner.scope = hasIndex ? indexScope : itemScope;
+            std::string body = emitNodes(node.body, inner, depth);
+
+            bindings.resize(bindings.size() - (hasIndex ? 2 : 1));
+
+            std::string frames;
+            if (hasIndex && uses(body, indexScope))
+                frames = in + "Scope " + indexScope + "{&" + itemScope + ", {}, " + name(node.indexVar) + ", " + index + "};\n";
+            if (uses(body, itemScope) || !frames.empty())
+                frames = in + "Scope " + itemScope + "{&" + context.scope + ", {}, " + name(node.itemVar) + ", " + item + "};\n" + frames;
+
+            return frames + body;
+        }
+
+        void emitFor(const Node &node, const Context &context, int depth, std::ostringstream &code)
+        {
+            std::string in = pad(depth);
+
+            code << in << "{\n";
+            std::string collection = emitExpression(node.expr, context, depth + 1, code);
+
+            std::string element = next("e");
+            std::string position = next("i");
+            std::string count = next("n");
+            std::string body = emitLoopBody(node, context, depth + 3, element, "Value::of(" + position + ")");
+
+            code << in << "    if (" << collection << ".isArray())\n"
+                 << in << "    {\n"
+                 << in << "        for (size_t " << position << " = 0, " << count << " = " << collection << ".size(); "
+                 << position << " < " << count << "; ++" << position << ")\n"
+                 << in << "        {\n"
+                 << in << "            Value " << element << " = " << collection << ".at(" << position << ");\n"
+                 << body
+                 << in << "        }\n"
+                 << in << "    }\n";
+
+            std::string key = next("k");
+            std::string member = next("m");
+            body = emitLoopBody(node, context, depth + 3, key, member);
+
+            code << in << "    else if (" << collection << ".isObject())\n"
+                 << in << "    {\n"
+                 << in << "        " << collection << ".each([&](const Value &" << key << ", const Value &" << member << ")\n"
+                 << in << "        {\n"
+                 << body
+                 << in << "        });\n"
+                 << in << "    }\n"
+                 << in << "}\n";
+        }
+
+        void emitInclude(const Node &node, const Context &context, int depth, std::ostringstream &code)
+        {
+            std::string in = pad(depth);
+            bool generated = views.count(node.templateName) != 0;
+
+            auto call = [&](const std::string &scope)
+            {
+                return generated ? identifier(node.templateName) + "(engine, " + scope + ", " + context.out + ", filters);\n"
+                                 : "engine.include(" + name(node.templateName) + ", " + scope + ", " + context.out + ");\n";
+            };
+
+            if (!node.hasWith)
+            {
+                code << in << call(context.scope);
+                return;
+            }
+
+            std::string frame = next("f");
+            code << in << "{\n";
+            std::string value = emitExpression(node.expr, context, depth + 1, code);
+            code << in << "    if (!" << value << ".isNull())\n"
+                 << in << "    {\n"
+                 << in << "        Scope " << frame << "{&" << context.scope << ", {}, \"it\", " << value << "};\n"
+                 << in << "        " << call(frame)
+                 << in << "    }\n"
+                 << in << "}\n";
+        }
+
+        void emitCache(const Node &node, const Context &context, int depth, std::ostringstream &code)
+        {
+            std::string in = pad(depth);
+            std::string key = next("key");
+            std::string bytes = next("b");
+            std::string buffer = next("fb");
+            std::string fragment = next("fo");
+
+            code << in << "{\n"
+                 << in << "    std::string " << key << ";\n";
+            for (const Expression &part : node.cacheKey)
+            {
+                std::string value = emitExpression(part, context, depth + 1, code);
+                code << in << "    " << key << " += View::text(" << value << ");\n";
+            }
+
+            Context inner{context.scope, fragment, false};
+            code << in << "    auto " << bytes << " = engine.findFragment(" << key << ");\n"
+                 << in << "    if (!" << bytes << ")\n"
+                 << in << "    {\n"
+                 << in << "        Http::OutputBuffer " << buffer << ";\n"
+                 << in << "        Output " << fragment << "{" << buffer << "};\n"
+                 << emitNodes(node.body, inner, depth + 2)
+                 << in << "        " << bytes << " = engine.storeFragment(" << key << ", " << node.ttl << ", " << buffer << ");\n"
+                 << in << "    }\n"
+                 << in << "    " << context.out << ".buffer.retain(" << bytes << ");\n"
+                 << in << "    " << context.out << ".buffer.reference(*" << bytes << ");\n"
+                 << in << "}\n";
+        }
+    };
+}
+
+int main(int argc, char **argv)
+{
+    // Declared filters only need a name here; the engine binds the real ones.
+    FilterRegistry filters;
+    int first = 1;
+    for (; first < argc && std::string_view(argv[first]).starts_with("--filter="); ++first)
+        filters.add(argv[first] + 9, [](const json &value, const FilterArguments &)
+                    { return value; });
+
+    if (argc - first < 2)
+    {
+        std::cerr << "usage: " << argv[0] << " [--filter=name]... <output.cpp> <view.html>..." << std::endl;
+        return 2;
+    }
+
+    std::map<std::string, std::string> views;
+    for (int i = first + 1; i < argc; ++i)
+    {
+        std::filesystem::path path(argv[i]);
+        std::ifstream file(path);
+        if (!file.is_open())
+        {
+            std::cerr << "Could not open template file: " << path.string() << std::endl;
+            return 1;
+        }
+
+        std::stringstream source;
+        source << file.rdbuf();
+        views[path.stem().string()] = source.str();
+    }
+
+    std::string code;
+    try
+    {
+        code = Generator(std::move(views), filters).generate();
+    }
+    catch (const std::runtime_error &e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    std::ofstream output(argv[first]);
+    output << code;
+    if (!output)
+    {
+        std::cerr << "Could not write " << argv[first] << std::endl;
+        return 1;
+    }
+    return 0;
+}